@@ -0,0 +1,390 @@
+/*Microbenchmarks of the hot kernels of the pricers.
+Usage : VarianceSwapsBenchmarks [--min-time seconds] [--filter substring] [--csv file] [--json file]
+Each benchmark is repeated, doubling its number of iterations, until it runs for at least min-time
+seconds (0.5 by default). The results are printed and, if requested, written in csv and json files
+so that they can be compared between versions */
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include "HestonLogSpotPathSimulator.h"
+#include "HestonVariancePathSimulator.h"
+#include "RandomVariablesGenerator.h"
+#include "VarianceSwap.h"
+#include "MathFunctions.h"
+#include "LookupTable.h"
+#include "TimeGrid.h"
+#include "VarianceSwapsHestonMonteCarloPricer.h"
+#include "VarianceSwapsHestonAnalyticalPricer.h"
+
+struct Benchmark
+{
+    std::string name;
+    //Function running the kernel the given number of iterations
+    std::function<void(std::size_t)> run;
+    //Operations, paths and time steps of paths done by one iteration (0 if not relevant)
+    double opsPerIteration;
+    double pathsPerIteration;
+    double stepsPerIteration;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::size_t nbIterations;
+    double nsPerOp;
+    double opsPerSecond;
+    double pathsPerSecond;
+    double stepsPerSecond;
+};
+
+//The results of the kernels are accumulated in this variable so that the compiler can't remove them
+volatile double sink = 0.;
+
+BenchmarkResult runBenchmark(const Benchmark& benchmark, double minTime)
+{
+    std::size_t nbIterations = 1;
+    double time = 0.;
+    //Warm-up, which also fills the caches of the pricers that keep some
+    benchmark.run(1);
+    while(true)
+    {
+        auto start = std::chrono::steady_clock::now();
+        benchmark.run(nbIterations);
+        time = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        if(time >= minTime)
+            break;
+        nbIterations *= 2;
+    }
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.nbIterations = nbIterations;
+    result.nsPerOp = 1e9*time/(nbIterations*benchmark.opsPerIteration);
+    result.opsPerSecond = nbIterations*benchmark.opsPerIteration/time;
+    result.pathsPerSecond = nbIterations*benchmark.pathsPerIteration/time;
+    result.stepsPerSecond = nbIterations*benchmark.stepsPerIteration/time;
+    return result;
+}
+
+std::vector<Benchmark> buildBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //Variance swap with monthly observations, simulated on a grid of 20 points per month
+    double maturity = 1.0;
+    size_t nbOfObservations = 13;
+    VarianceSwap varianceSwap(maturity,nbOfObservations);
+    size_t nbTimePoints = 241;
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,maturity,nbTimePoints);
+    //The simulators are shared by the benchmarks, which outlive this function
+    std::shared_ptr<TruncatedGaussianScheme> truncatedGaussianScheme =
+            std::make_shared<TruncatedGaussianScheme>(timePoints,hestonModel);
+    std::shared_ptr<QuadraticExponentialScheme> quadraticExponentialScheme =
+            std::make_shared<QuadraticExponentialScheme>(timePoints,hestonModel);
+    std::shared_ptr<NoncentralChiSquareScheme> noncentralChiSquareScheme =
+            std::make_shared<NoncentralChiSquareScheme>(timePoints,hestonModel);
+    std::shared_ptr<BroadieKayaScheme> broadieKayaSchemeTG = std::make_shared<BroadieKayaScheme>(*truncatedGaussianScheme);
+    std::shared_ptr<BroadieKayaScheme> broadieKayaSchemeQE = std::make_shared<BroadieKayaScheme>(*quadraticExponentialScheme);
+    std::shared_ptr<BroadieKayaScheme> broadieKayaSchemeNCX2 =
+            std::make_shared<BroadieKayaScheme>(*noncentralChiSquareScheme);
+    std::vector<std::size_t> observationIndexes = TimeGrid::observationIndexes(timePoints, varianceSwap.getDates());
+
+    const std::size_t nbDraws = 1024;
+    benchmarks.push_back({"simulateGaussianRandomVariable", [](std::size_t nbIterations)
+    {
+        RandomStream stream(MathFunctions::seed);
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+            for(std::size_t i = 0; i < nbDraws; i++)
+                sum += MathFunctions::simulateGaussianRandomVariable(stream);
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    benchmarks.push_back({"simulateZigguratGaussianRandomVariable", [](std::size_t nbIterations)
+    {
+        RandomStream stream(MathFunctions::seed);
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+            for(std::size_t i = 0; i < nbDraws; i++)
+                sum += MathFunctions::simulateZigguratGaussianRandomVariable(stream);
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    //Uniforms and Gaussian variables shared by the kernels below
+    std::shared_ptr<std::vector<double>> uniforms = std::make_shared<std::vector<double>>(nbDraws);
+    std::shared_ptr<std::vector<double>> gaussians = std::make_shared<std::vector<double>>(nbDraws);
+    RandomStream stream(MathFunctions::seed);
+    MathFunctions::simulateUniformRandomVariables(uniforms->data(), nbDraws, stream);
+    MathFunctions::simulateGaussianRandomVariables(gaussians->data(), nbDraws, stream);
+
+    benchmarks.push_back({"normalCDFInverse", [uniforms](std::size_t nbIterations)
+    {
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+            for(std::size_t i = 0; i < nbDraws; i++)
+                sum += MathFunctions::normalCDFInverse((*uniforms)[i]);
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    benchmarks.push_back({"normalCDFInverse (batch)", [uniforms](std::size_t nbIterations)
+    {
+        std::vector<double> result(nbDraws);
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+        {
+            MathFunctions::normalCDFInverse(uniforms->data(), result.data(), nbDraws);
+            sum += result[it%nbDraws];
+        }
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    /*Look-up of two tabulated functions at points spread over the table : binary search on the grid with
+    linear interpolation, as in the first TG implementation, against the O(1) cubic table */
+    std::shared_ptr<std::vector<double>> grid = std::make_shared<std::vector<double>>(
+                                                        MathFunctions::buildLinearSpace(1., 2., 100));
+    std::shared_ptr<std::vector<double>> gridValues = std::make_shared<std::vector<double>>();
+    for(std::size_t i = 0; i < grid->size(); i++)
+    {
+        gridValues->push_back(std::log((*grid)[i]));
+        gridValues->push_back(std::sqrt((*grid)[i]));
+    }
+    benchmarks.push_back({"binarySearch + linear interpolation", [uniforms, grid, gridValues](std::size_t nbIterations)
+    {
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+            for(std::size_t i = 0; i < nbDraws; i++)
+            {
+                double x = 1. + (*uniforms)[i];
+                std::size_t idx = MathFunctions::binarySearch(*grid, x);
+                double x0 = (*grid)[idx], x1 = (*grid)[idx+1];
+                for(std::size_t functionIdx = 0; functionIdx < 2; functionIdx++)
+                    sum += ((*gridValues)[2*idx+functionIdx]*(x1-x)
+                            + (*gridValues)[2*idx+2+functionIdx]*(x-x0))/(x1-x0);
+            }
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    std::shared_ptr<LookupTable> lookupTable = std::make_shared<LookupTable>([](double x, double* values)
+    {
+        values[0] = std::log(x);
+        values[1] = std::sqrt(x);
+    }, 2, 1., 2., 32);
+    benchmarks.push_back({"LookupTable::evaluate", [uniforms, lookupTable](std::size_t nbIterations)
+    {
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+            for(std::size_t i = 0; i < nbDraws; i++)
+            {
+                double values[2];
+                lookupTable->evaluate<2>(1. + (*uniforms)[i], values);
+                sum += values[0] + values[1];
+            }
+        sink = sink + sum;
+    }, double(nbDraws), 0., 0.});
+
+    /*The schemes advance the paths on blocks of nbDraws paths, path by path with the scalar nextStep and at once
+    with nextStepBlock. One operation is the step of one path, the step index going through the whole grid.
+    The random variables change at each step, as in the pricers : reusing the same ones would make the branches
+    of the scalar schemes predictable */
+    const std::size_t nbSteps = nbTimePoints-1;
+    std::shared_ptr<std::vector<double>> stepUniforms = std::make_shared<std::vector<double>>(nbSteps*nbDraws);
+    std::shared_ptr<std::vector<double>> stepGaussians = std::make_shared<std::vector<double>>(nbSteps*nbDraws);
+    MathFunctions::simulateUniformRandomVariables(stepUniforms->data(), nbSteps*nbDraws, stream);
+    MathFunctions::simulateGaussianRandomVariables(stepGaussians->data(), nbSteps*nbDraws, stream);
+    std::vector<std::pair<std::string, std::shared_ptr<HestonVariancePathSimulator>>> varianceSchemes =
+        {{"TruncatedGaussianScheme", truncatedGaussianScheme},
+         {"QuadraticExponentialScheme", quadraticExponentialScheme},
+         {"NoncentralChiSquareScheme", noncentralChiSquareScheme}};
+    for(std::size_t schemeIdx = 0; schemeIdx < varianceSchemes.size(); schemeIdx++)
+    {
+        std::shared_ptr<HestonVariancePathSimulator> scheme = varianceSchemes[schemeIdx].second;
+        std::shared_ptr<std::vector<double>> randomVariables =
+                scheme->getRandomVariableType() == RandomVariableType::Uniform ? stepUniforms : stepGaussians;
+        benchmarks.push_back({varianceSchemes[schemeIdx].first + "::nextStep", [scheme, randomVariables, V0, nbSteps]
+                              (std::size_t nbIterations)
+        {
+            std::vector<double> currentValues(nbDraws, V0), nextValues(nbDraws);
+            for(std::size_t it = 0; it < nbIterations; it++)
+            {
+                const double* stepRandomVariables = &(*randomVariables)[(it%nbSteps)*nbDraws];
+                for(std::size_t p = 0; p < nbDraws; p++)
+                    nextValues[p] = scheme->nextStep(it%nbSteps, currentValues[p], stepRandomVariables[p]);
+                std::swap(currentValues, nextValues);
+            }
+            sink = sink + currentValues[0];
+        }, double(nbDraws), 0., double(nbDraws)});
+        benchmarks.push_back({varianceSchemes[schemeIdx].first + "::nextStepBlock", [scheme, randomVariables, V0, nbSteps]
+                              (std::size_t nbIterations)
+        {
+            std::vector<double> currentValues(nbDraws, V0), nextValues(nbDraws);
+            for(std::size_t it = 0; it < nbIterations; it++)
+            {
+                scheme->nextStepBlock(it%nbSteps, currentValues.data(), &(*randomVariables)[(it%nbSteps)*nbDraws],
+                                      nextValues.data(), nbDraws);
+                std::swap(currentValues, nextValues);
+            }
+            sink = sink + currentValues[0];
+        }, double(nbDraws), 0., double(nbDraws)});
+    }
+
+    benchmarks.push_back({"BroadieKayaScheme::nextStepBlock", [broadieKayaSchemeQE, gaussians, V0, X0, nbTimePoints]
+                          (std::size_t nbIterations)
+    {
+        const BroadieKayaScheme& scheme = *broadieKayaSchemeQE;
+        std::vector<double> currentValues(nbDraws, std::log(X0)), nextValues(nbDraws);
+        std::vector<double> currentVariances(nbDraws, V0), nextVariances(nbDraws, V0);
+        for(std::size_t it = 0; it < nbIterations; it++)
+        {
+            scheme.nextStepBlock(it%(nbTimePoints-1), currentValues.data(), currentVariances.data(),
+                                 nextVariances.data(), gaussians->data(), nextValues.data(), nbDraws);
+            std::swap(currentValues, nextValues);
+        }
+        sink = sink + currentValues[0];
+    }, double(nbDraws), 0., double(nbDraws)});
+
+    //Full paths, one operation being one path of the grid
+    std::vector<std::pair<std::string, std::shared_ptr<BroadieKayaScheme>>> logSpotSchemes =
+        {{"BKTG", broadieKayaSchemeTG}, {"BKQE", broadieKayaSchemeQE}, {"BKNCX2", broadieKayaSchemeNCX2}};
+    for(std::size_t schemeIdx = 0; schemeIdx < logSpotSchemes.size(); schemeIdx++)
+    {
+        std::shared_ptr<BroadieKayaScheme> scheme = logSpotSchemes[schemeIdx].second;
+        benchmarks.push_back({logSpotSchemes[schemeIdx].first+" path", [scheme](std::size_t nbIterations)
+        {
+            RandomStream stream(MathFunctions::seed);
+            double sum = 0.;
+            for(std::size_t it = 0; it < nbIterations; it++)
+                sum += scheme->path(stream).back();
+            sink = sink + sum;
+        }, 1., 1., double(nbTimePoints-1)});
+
+        const std::size_t blockSize = 256;
+        benchmarks.push_back({logSpotSchemes[schemeIdx].first+" sumOfSquaredLogReturns",
+                              [scheme, observationIndexes](std::size_t nbIterations)
+        {
+            double sum = 0.;
+            for(std::size_t it = 0; it < nbIterations; it++)
+            {
+                PseudoRandomVariablesGenerator generator(MathFunctions::seed, it*blockSize, blockSize);
+                sum += scheme->sumOfSquaredLogReturns(generator, observationIndexes).front();
+            }
+            sink = sink + sum;
+        }, double(blockSize), double(blockSize), double(blockSize*(nbTimePoints-1))});
+    }
+
+    //Prices, one operation being one price
+    const std::size_t nbSimulations = 10000;
+    for(std::size_t schemeIdx = 0; schemeIdx < logSpotSchemes.size(); schemeIdx++)
+    {
+        std::shared_ptr<VarianceSwapsHestonMonteCarloPricer> mcPricer =
+                std::make_shared<VarianceSwapsHestonMonteCarloPricer>(*logSpotSchemes[schemeIdx].second, nbSimulations);
+        benchmarks.push_back({"VarianceSwapsHestonMonteCarloPricer::price "+logSpotSchemes[schemeIdx].first,
+                              [mcPricer, varianceSwap](std::size_t nbIterations)
+        {
+            double sum = 0.;
+            for(std::size_t it = 0; it < nbIterations; it++)
+                sum += mcPricer->price(varianceSwap);
+            sink = sink + sum;
+        }, 1., double(nbSimulations), double(nbSimulations*(nbTimePoints-1))});
+    }
+
+    //The analytical pricer caches the terms of the periods : a new pricer is built for each price
+    VarianceSwap dailyVarianceSwap(maturity, 253);
+    benchmarks.push_back({"VarianceSwapsHestonAnalyticalPricer::price", [hestonModel, dailyVarianceSwap]
+                          (std::size_t nbIterations)
+    {
+        double sum = 0.;
+        for(std::size_t it = 0; it < nbIterations; it++)
+        {
+            VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+            sum += anPricer.price(dailyVarianceSwap);
+        }
+        sink = sink + sum;
+    }, 1., 0., 0.});
+
+    return benchmarks;
+}
+
+//Rates that are not relevant for a benchmark (0 paths or steps per operation) are written as missing
+std::string formatRate(double rate, const std::string& missing)
+{
+    if(rate == 0.)
+        return missing;
+    std::ostringstream stream;
+    stream << std::setprecision(10) << rate;
+    return stream.str();
+}
+
+int main(int argc, char* argv[])
+{
+    double minTime = 0.5;
+    std::string filter, csvFileName, jsonFileName;
+    for(int i = 1; i < argc; i += 2)
+    {
+        //Every option takes a value : an option given last without one is rejected as unknown
+        const char* value = i+1 < argc ? argv[i+1] : nullptr;
+        if(value && std::strcmp(argv[i], "--min-time") == 0)
+            minTime = std::stod(value);
+        else if(value && std::strcmp(argv[i], "--filter") == 0)
+            filter = value;
+        else if(value && std::strcmp(argv[i], "--csv") == 0)
+            csvFileName = value;
+        else if(value && std::strcmp(argv[i], "--json") == 0)
+            jsonFileName = value;
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    std::vector<Benchmark> benchmarks = buildBenchmarks();
+    std::cout << std::left << std::setw(60) << "Benchmark" << std::right << std::setw(14) << "ns/op"
+              << std::setw(14) << "paths/s" << std::setw(14) << "steps/s" << std::endl;
+    for(std::size_t benchmarkIdx = 0; benchmarkIdx < benchmarks.size(); benchmarkIdx++)
+    {
+        if(benchmarks[benchmarkIdx].name.find(filter) == std::string::npos)
+            continue;
+        BenchmarkResult result = runBenchmark(benchmarks[benchmarkIdx], minTime);
+        results.push_back(result);
+        std::cout << std::left << std::setw(60) << result.name << std::right << std::setprecision(4)
+                  << std::setw(14) << result.nsPerOp << std::setw(14) << formatRate(result.pathsPerSecond, "-")
+                  << std::setw(14) << formatRate(result.stepsPerSecond, "-") << std::endl;
+    }
+
+    if(!csvFileName.empty())
+    {
+        std::ofstream file(csvFileName);
+        file << "Benchmark;Iterations;ns/op;ops/s;paths/s;steps/s\n";
+        for(std::size_t i = 0; i < results.size(); i++)
+            file << results[i].name << ";" << results[i].nbIterations << ";" << results[i].nsPerOp << ";"
+                 << results[i].opsPerSecond << ";" << results[i].pathsPerSecond << ";"
+                 << results[i].stepsPerSecond << "\n";
+    }
+    if(!jsonFileName.empty())
+    {
+        std::ofstream file(jsonFileName);
+        file << std::setprecision(10) << "{\n  \"compiler\": \"" << __VERSION__ << "\",\n"
+             << "  \"min_time\": " << minTime << ",\n  \"benchmarks\": [\n";
+        for(std::size_t i = 0; i < results.size(); i++)
+            file << "    {\"name\": \"" << results[i].name << "\", \"iterations\": " << results[i].nbIterations
+                 << ", \"ns_per_op\": " << results[i].nsPerOp << ", \"ops_per_second\": " << results[i].opsPerSecond
+                 << ", \"paths_per_second\": " << formatRate(results[i].pathsPerSecond, "null")
+                 << ", \"steps_per_second\": " << formatRate(results[i].stepsPerSecond, "null") << "}"
+                 << (i+1 < results.size() ? ",\n" : "\n");
+        file << "  ]\n}\n";
+    }
+    return 0;
+}
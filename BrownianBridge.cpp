@@ -0,0 +1,99 @@
+#include <cmath>
+#include <algorithm>
+#include "BrownianBridge.h"
+
+BrownianBridge::BrownianBridge(const std::vector<double>& timePoints):
+    nbSteps_(timePoints.size()-1), stepLengths_(nbSteps_), times_(nbSteps_), bridgeIndex_(nbSteps_),
+    leftIndex_(nbSteps_), rightIndex_(nbSteps_), leftWeight_(nbSteps_),
+    rightWeight_(nbSteps_), stdDev_(nbSteps_)
+{
+    std::vector<double>& t = times_;
+    for(std::size_t i = 0; i < nbSteps_; i++)
+    {
+        t[i] = timePoints[i+1]-timePoints[0];
+        stepLengths_[i] = timePoints[i+1]-timePoints[i];
+    }
+
+    //map[i] is non zero once the value at t[i] is built
+    std::vector<std::size_t> map(nbSteps_, 0);
+    map[nbSteps_-1] = 1;
+    bridgeIndex_[0] = nbSteps_-1;
+    stdDev_[0] = std::sqrt(t[nbSteps_-1]);
+    std::size_t j = 0;
+    for(std::size_t i = 1; i < nbSteps_; i++)
+    {
+        //We look for the next interval ]j-1,k[ whose inner points are not built yet
+        while(map[j])
+            j++;
+        std::size_t k = j;
+        while(!map[k])
+            k++;
+        //Its midpoint is built from its ends
+        std::size_t l = j + ((k-1-j) >> 1);
+        map[l] = i;
+        bridgeIndex_[i] = l;
+        leftIndex_[i] = j;
+        rightIndex_[i] = k;
+        double tLeft = j > 0 ? t[j-1] : 0.;
+        leftWeight_[i] = (t[k]-t[l])/(t[k]-tLeft);
+        rightWeight_[i] = (t[l]-tLeft)/(t[k]-tLeft);
+        stdDev_[i] = std::sqrt((t[l]-tLeft)*(t[k]-t[l])/(t[k]-tLeft));
+        j = k+1;
+        if(j >= nbSteps_)
+            j = 0;
+    }
+}
+
+std::size_t BrownianBridge::getNbSteps() const
+{
+    return nbSteps_;
+}
+
+void BrownianBridge::transform(const double* gaussians, double* increments, double* workspace) const
+{
+    double* path = workspace;
+    coarseTransform(gaussians, nbSteps_, path);
+    increments[0] = path[0]/std::sqrt(stepLengths_[0]);
+    for(std::size_t i = 1; i < nbSteps_; i++)
+        increments[i] = (path[i]-path[i-1])/std::sqrt(stepLengths_[i]);
+}
+
+std::vector<std::size_t> BrownianBridge::coarseIndexes(std::size_t nbCoarse) const
+{
+    std::vector<std::size_t> indexes(bridgeIndex_.begin(), bridgeIndex_.begin()+nbCoarse);
+    std::sort(indexes.begin(), indexes.end());
+    return indexes;
+}
+
+void BrownianBridge::coarseTransform(const double* gaussians, std::size_t nbCoarse, double* path) const
+{
+    //The ends of the interval of each variable are built by the previous ones
+    path[nbSteps_-1] = stdDev_[0]*gaussians[0];
+    for(std::size_t i = 1; i < nbCoarse; i++)
+    {
+        std::size_t j = leftIndex_[i], k = rightIndex_[i], l = bridgeIndex_[i];
+        double left = j > 0 ? path[j-1] : 0.;
+        path[l] = leftWeight_[i]*left + rightWeight_[i]*path[k] + stdDev_[i]*gaussians[i];
+    }
+}
+
+void BrownianBridge::fineStep(std::size_t stepIndex, std::size_t coarseIndex, double& weight, double& stdDev) const
+{
+    double sqrtStepLength = std::sqrt(stepLengths_[stepIndex]);
+    if(coarseIndex == stepIndex)
+    {
+        weight = 1./sqrtStepLength;
+        stdDev = 0.;
+        return;
+    }
+    //Brownian bridge from the start of the step to the coarse index, observed at the end of the step
+    double start = stepIndex > 0 ? times_[stepIndex-1] : 0.;
+    double length = times_[coarseIndex] - start;
+    weight = sqrtStepLength/length;
+    stdDev = std::sqrt((times_[coarseIndex] - times_[stepIndex])/length);
+}
+
+double BrownianBridge::getStepLength(std::size_t stepIndex) const
+{
+    return stepLengths_[stepIndex];
+}
@@ -0,0 +1,47 @@
+#ifndef BROWNIANBRIDGE_H
+#define BROWNIANBRIDGE_H
+
+#include <vector>
+
+/*Brownian bridge construction of a Brownian motion on a (possibly non-equidistant) time grid.
+The first Gaussian variable gives the value at the last time point, the next ones the values at the
+midpoints of the intervals already built, and so on. Most of the variance of the path is thus carried
+by the first variables, which keeps the effective dimension low when they are quasi-random */
+class BrownianBridge
+{
+private:
+    std::size_t nbSteps_;
+    std::vector<double> stepLengths_;
+    //times_[i] is the time elapsed between the first time point and the (i+1)-th one
+    std::vector<double> times_;
+    //The i-th Gaussian variable gives the value at bridgeIndex_[i], from the values at leftIndex_[i]-1
+    //(or the origin if leftIndex_[i] = 0) and rightIndex_[i]
+    std::vector<std::size_t> bridgeIndex_;
+    std::vector<std::size_t> leftIndex_;
+    std::vector<std::size_t> rightIndex_;
+    std::vector<double> leftWeight_;
+    std::vector<double> rightWeight_;
+    std::vector<double> stdDev_;
+public:
+    BrownianBridge(const std::vector<double>& timePoints);
+    std::size_t getNbSteps() const;
+
+    /*Maps the nbSteps Gaussian variables gaussians (in bridge order) to the normalized increments
+    (W(t_i+1)-W(t_i))/sqrt(t_i+1-t_i) of the Brownian motion, which are independent standard Gaussian
+    variables. workspace must hold nbSteps values */
+    void transform(const double* gaussians, double* increments, double* workspace) const;
+
+    /*The first nbCoarse variables alone give the values of the path at nbCoarse time indexes, the coarse indexes.
+    coarseIndexes returns them sorted, and coarseTransform computes the values of path at them, path holding
+    nbSteps values of which the others are left unset. Given the coarse values, the rest of the path is made of
+    independent bridges, which can be drawn one step at a time with fineStep */
+    std::vector<std::size_t> coarseIndexes(std::size_t nbCoarse) const;
+    void coarseTransform(const double* gaussians, std::size_t nbCoarse, double* path) const;
+    /*Coefficients of the step stepIndex given the value W of the path at its start and the value A at the next
+    coarse index coarseIndex >= stepIndex : the normalized increment of the step is weight (A - W) + stdDev Z,
+    Z being a standard Gaussian variable independent of the path up to the start of the step */
+    void fineStep(std::size_t stepIndex, std::size_t coarseIndex, double& weight, double& stdDev) const;
+    double getStepLength(std::size_t stepIndex) const;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+#include <cstddef>
+
+/*Dual number for forward mode automatic differentiation with respect to N variables at once : value
+and gradient of a real quantity. Arithmetic on dual numbers applies the chain rule, so that evaluating
+a formula on the dual numbers of the variables gives its exact gradient */
+template<std::size_t N>
+struct Dual
+{
+    double value;
+    double derivatives[N];
+
+    Dual(double value = 0.): value(value)
+    {
+        for(std::size_t i = 0; i < N; i++)
+            derivatives[i] = 0.;
+    }
+
+    //Dual number of the variable of index i at the point x
+    static Dual variable(double x, std::size_t i)
+    {
+        Dual dual(x);
+        dual.derivatives[i] = 1.;
+        return dual;
+    }
+};
+
+/*Dual number of f(u), given f(u) and f'(u) at the value of u */
+template<std::size_t N>
+Dual<N> compose(const Dual<N>& u, double f, double fPrime)
+{
+    Dual<N> result(f);
+    for(std::size_t i = 0; i < N; i++)
+        result.derivatives[i] = fPrime*u.derivatives[i];
+    return result;
+}
+
+template<std::size_t N>
+Dual<N> operator-(const Dual<N>& u)
+{
+    return compose(u, -u.value, -1.);
+}
+
+template<std::size_t N>
+Dual<N> operator+(const Dual<N>& u, const Dual<N>& v)
+{
+    Dual<N> result(u.value+v.value);
+    for(std::size_t i = 0; i < N; i++)
+        result.derivatives[i] = u.derivatives[i]+v.derivatives[i];
+    return result;
+}
+
+template<std::size_t N>
+Dual<N> operator-(const Dual<N>& u, const Dual<N>& v)
+{
+    Dual<N> result(u.value-v.value);
+    for(std::size_t i = 0; i < N; i++)
+        result.derivatives[i] = u.derivatives[i]-v.derivatives[i];
+    return result;
+}
+
+template<std::size_t N>
+Dual<N> operator*(const Dual<N>& u, const Dual<N>& v)
+{
+    Dual<N> result(u.value*v.value);
+    for(std::size_t i = 0; i < N; i++)
+        result.derivatives[i] = u.derivatives[i]*v.value+u.value*v.derivatives[i];
+    return result;
+}
+
+template<std::size_t N>
+Dual<N> operator/(const Dual<N>& u, const Dual<N>& v)
+{
+    Dual<N> result(u.value/v.value);
+    for(std::size_t i = 0; i < N; i++)
+        result.derivatives[i] = (u.derivatives[i]-result.value*v.derivatives[i])/v.value;
+    return result;
+}
+
+//Operations with real constants
+template<std::size_t N>
+Dual<N> operator+(const Dual<N>& u, double c) { return compose(u, u.value+c, 1.); }
+template<std::size_t N>
+Dual<N> operator+(double c, const Dual<N>& u) { return compose(u, c+u.value, 1.); }
+template<std::size_t N>
+Dual<N> operator-(const Dual<N>& u, double c) { return compose(u, u.value-c, 1.); }
+template<std::size_t N>
+Dual<N> operator-(double c, const Dual<N>& u) { return compose(u, c-u.value, -1.); }
+template<std::size_t N>
+Dual<N> operator*(const Dual<N>& u, double c) { return compose(u, u.value*c, c); }
+template<std::size_t N>
+Dual<N> operator*(double c, const Dual<N>& u) { return compose(u, c*u.value, c); }
+template<std::size_t N>
+Dual<N> operator/(const Dual<N>& u, double c) { return compose(u, u.value/c, 1./c); }
+template<std::size_t N>
+Dual<N> operator/(double c, const Dual<N>& u) { return compose(u, c/u.value, -c/(u.value*u.value)); }
+
+template<std::size_t N>
+Dual<N> exp(const Dual<N>& u)
+{
+    double e = std::exp(u.value);
+    return compose(u, e, e);
+}
+
+template<std::size_t N>
+Dual<N> log(const Dual<N>& u)
+{
+    return compose(u, std::log(u.value), 1./u.value);
+}
+
+template<std::size_t N>
+Dual<N> sqrt(const Dual<N>& u)
+{
+    double s = std::sqrt(u.value);
+    return compose(u, s, 0.5/s);
+}
+
+#endif
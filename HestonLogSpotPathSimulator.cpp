@@ -1,6 +1,8 @@
 #include <cmath>
 #include "HestonLogSpotPathSimulator.h"
+#include "Instrumentation.h"
 #include "MathFunctions.h"
+#include "RandomVariablesGenerator.h"
 
 HestonLogSpotPathSimulator::HestonLogSpotPathSimulator(
                                 const HestonVariancePathSimulator& variancePathSimulator):
@@ -40,18 +42,133 @@ HestonLogSpotPathSimulator& HestonLogSpotPathSimulator::operator=(
 	return *this;
 }
 
-std::vector<double> HestonLogSpotPathSimulator::path() const
+HestonModel HestonLogSpotPathSimulator::getHestonModel() const
+{
+    return variancePathSimulator_->getHestonModel();
+}
+
+std::vector<double> HestonLogSpotPathSimulator::path(RandomStream& stream) const
 {
     std::vector<double> logSpotPath {initialValue_};
     //We compute the variance path at this stage once for all and we pass it to nextStep
     //It's not a class attribute in order to avoid that path is non const
-    std::vector<double>  variancePath = variancePathSimulator_->path();
+    std::vector<double>  variancePath = variancePathSimulator_->path(stream);
+    RandomVariableType randomVariableType = getRandomVariableType();
 	for (std::size_t index = 0; index < timePoints_.size() - 1; ++index)
-		logSpotPath.push_back(nextStep(index, logSpotPath[index], variancePath));
+		logSpotPath.push_back(nextStep(index, logSpotPath[index], variancePath,
+                                       simulateRandomVariable(randomVariableType, stream), stream));
 
 	return logSpotPath;
 }
 
+std::vector<double> HestonLogSpotPathSimulator::pathBlock(RandomVariablesGenerator& randomVariablesGenerator) const
+{
+    std::size_t nbPaths = randomVariablesGenerator.getNbPaths();
+    std::vector<double> logSpotBlock(timePoints_.size()*nbPaths, initialValue_);
+    std::vector<double> currentVariances(nbPaths,
+                                variancePathSimulator_->getHestonModel().getInitialVolatility());
+    std::vector<double> nextVariances(nbPaths);
+    std::vector<double> varianceRandomVariables(nbPaths), randomVariables(nbPaths);
+    RandomVariableType varianceRandomVariableType = variancePathSimulator_->getRandomVariableType();
+    RandomVariableType randomVariableType = getRandomVariableType();
+    bool varianceDrawsAdditionalRandomVariables = variancePathSimulator_->drawsAdditionalRandomVariables();
+    bool drawsAdditionalRandomVariables = this->drawsAdditionalRandomVariables();
+    for (std::size_t index = 0; index < timePoints_.size() - 1; ++index)
+    {
+        randomVariablesGenerator.simulateRandomVariables(index, 0, varianceRandomVariableType,
+                                                         varianceRandomVariables.data());
+        variancePathSimulator_->nextStepBlock(index, currentVariances.data(),
+                                              varianceRandomVariables.data(),
+                                              nextVariances.data(), nbPaths,
+                                              varianceDrawsAdditionalRandomVariables ?
+                                                  randomVariablesGenerator.auxiliaryStreams(index, 0) : nullptr);
+        randomVariablesGenerator.simulateRandomVariables(index, 1, randomVariableType, randomVariables.data());
+        nextStepBlock(index, &logSpotBlock[index*nbPaths], currentVariances.data(),
+                      nextVariances.data(), randomVariables.data(),
+                      &logSpotBlock[(index+1)*nbPaths], nbPaths,
+                      drawsAdditionalRandomVariables ? randomVariablesGenerator.auxiliaryStreams(index, 1) : nullptr);
+        currentVariances.swap(nextVariances);
+    }
+    return logSpotBlock;
+}
+
+std::vector<double> HestonLogSpotPathSimulator::sumOfSquaredLogReturns(
+                                    RandomVariablesGenerator& randomVariablesGenerator,
+                                    const std::vector<std::size_t>& observationIndexes,
+                                    std::vector<double>* integratedVariances) const
+{
+    std::size_t nbPaths = randomVariablesGenerator.getNbPaths();
+    std::vector<double> sums(nbPaths, 0.);
+    if(integratedVariances)
+        integratedVariances->assign(nbPaths, 0.);
+    std::vector<double> logSpots(nbPaths, initialValue_), lastObservedLogSpots(nbPaths, initialValue_);
+    std::vector<double> currentVariances(nbPaths,
+                                variancePathSimulator_->getHestonModel().getInitialVolatility());
+    std::vector<double> nextVariances(nbPaths);
+    std::vector<double> varianceRandomVariables(nbPaths), randomVariables(nbPaths);
+    RandomVariableType varianceRandomVariableType = variancePathSimulator_->getRandomVariableType();
+    RandomVariableType randomVariableType = getRandomVariableType();
+    bool varianceDrawsAdditionalRandomVariables = variancePathSimulator_->drawsAdditionalRandomVariables();
+    bool drawsAdditionalRandomVariables = this->drawsAdditionalRandomVariables();
+    RandomStream* varianceStreams = nullptr;
+    RandomStream* logSpotStreams = nullptr;
+
+    //Position in observationIndexes of the next observation to cross
+    std::size_t nextObservation = 0;
+    if(!observationIndexes.empty() && observationIndexes[0] == 0)
+        nextObservation = 1;
+    for (std::size_t index = 0; index < timePoints_.size() - 1
+                                && nextObservation < observationIndexes.size(); ++index)
+    {
+        {
+            INSTRUMENT_STAGE(RandomVariables, nbPaths);
+            randomVariablesGenerator.simulateRandomVariables(index, 0, varianceRandomVariableType,
+                                                             varianceRandomVariables.data());
+            randomVariablesGenerator.simulateRandomVariables(index, 1, randomVariableType, randomVariables.data());
+            if(varianceDrawsAdditionalRandomVariables)
+                varianceStreams = randomVariablesGenerator.auxiliaryStreams(index, 0);
+            if(drawsAdditionalRandomVariables)
+                logSpotStreams = randomVariablesGenerator.auxiliaryStreams(index, 1);
+        }
+        {
+            INSTRUMENT_STAGE(VarianceStep, nbPaths);
+            variancePathSimulator_->nextStepBlock(index, currentVariances.data(),
+                                                  varianceRandomVariables.data(),
+                                                  nextVariances.data(), nbPaths, varianceStreams);
+        }
+        {
+            INSTRUMENT_STAGE(LogSpotStep, nbPaths);
+            //The log-spots are updated in place
+            nextStepBlock(index, logSpots.data(), currentVariances.data(), nextVariances.data(),
+                          randomVariables.data(), logSpots.data(), nbPaths, logSpotStreams);
+        }
+        INSTRUMENT_STAGE(Observations, nbPaths);
+        if(integratedVariances && index >= observationIndexes[0])
+        {
+            double halfDelta = 0.5*(timePoints_[index+1] - timePoints_[index]);
+            for(std::size_t p = 0; p < nbPaths; p++)
+                (*integratedVariances)[p] += halfDelta*(currentVariances[p] + nextVariances[p]);
+        }
+        currentVariances.swap(nextVariances);
+
+        if(index+1 == observationIndexes[nextObservation])
+        {
+            //The first observation only sets the reference log-spot
+            if(nextObservation > 0)
+            {
+                for(std::size_t p = 0; p < nbPaths; p++)
+                {
+                    double logReturn = logSpots[p] - lastObservedLogSpots[p];
+                    sums[p] += logReturn*logReturn;
+                }
+            }
+            lastObservedLogSpots = logSpots;
+            nextObservation++;
+        }
+    }
+    return sums;
+}
+
 
 BroadieKayaScheme::BroadieKayaScheme(
                     const HestonVariancePathSimulator& variancePathSimulator,
@@ -66,6 +183,7 @@ BroadieKayaScheme::BroadieKayaScheme(
 BroadieKayaScheme::BroadieKayaScheme(const BroadieKayaScheme& broadieKayaScheme):
         HestonLogSpotPathSimulator(*broadieKayaScheme.variancePathSimulator_),
         gamma1_(broadieKayaScheme.gamma1_), gamma2_(broadieKayaScheme.gamma2_),
+        drift_(broadieKayaScheme.drift_),
         k0_(broadieKayaScheme.k0_), k1_(broadieKayaScheme.k1_),
         k2_(broadieKayaScheme.k2_), k3_(broadieKayaScheme.k3_),
         k4_(broadieKayaScheme.k4_)
@@ -81,6 +199,7 @@ void BroadieKayaScheme::preComputations()
     double kappa = hestonModel.getMeanReversionSpeed();
     double eps = hestonModel.getVolOfVol();
     double delta;
+    drift_ = hestonModel.getDrift();
 
     //NB : we allow the time grid to be non-equidistant so that the computed quantities are time dependent
     for(std::size_t i = 0; i < timePoints_.size()-1; i++)
@@ -97,14 +216,200 @@ BroadieKayaScheme* BroadieKayaScheme::clone() const{
     return new BroadieKayaScheme(*this);
 }
 
-double BroadieKayaScheme::nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath) const
+BroadieKayaScheme* BroadieKayaScheme::cloneWithModel(const HestonModel& hestonModel) const
+{
+    //The constructor clones the variance simulator, so the temporary one is deleted afterwards
+    HestonVariancePathSimulator* variancePathSimulator = variancePathSimulator_->cloneWithModel(hestonModel);
+    BroadieKayaScheme* broadieKayaScheme = new BroadieKayaScheme(*variancePathSimulator, gamma1_, gamma2_);
+    delete variancePathSimulator;
+    return broadieKayaScheme;
+}
+
+double BroadieKayaScheme::nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath,
+                                   double randomVariable, RandomStream& /*stream*/) const
 {   
-    double Z = MathFunctions::simulateGaussianRandomVariable();
+    double Z = randomVariable;
     return currentValue
-            +variancePathSimulator_->getHestonModel().getDrift()*(timePoints_[currentIndex+1] - timePoints_[currentIndex])
+            +drift_*(timePoints_[currentIndex+1] - timePoints_[currentIndex])
             +k0_[currentIndex]+k1_[currentIndex]*variancePath[currentIndex]
             +k2_[currentIndex]*variancePath[currentIndex+1]
             +std::sqrt(k3_[currentIndex]*variancePath[currentIndex]
                         +k4_[currentIndex]*variancePath[currentIndex+1])*Z;
 }
 
+RandomVariableType BroadieKayaScheme::getRandomVariableType() const
+{
+    return RandomVariableType::Gaussian;
+}
+
+void BroadieKayaScheme::nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                                      const double* currentVariances, const double* nextVariances,
+                                      const double* randomVariables, double* nextValues,
+                                      std::size_t nbPaths, RandomStream* /*streams*/) const
+{
+    //The path independent part of the step is computed once for the whole block
+    const double drift = drift_*(timePoints_[currentIndex+1] - timePoints_[currentIndex])
+                         +k0_[currentIndex];
+    const double k1 = k1_[currentIndex], k2 = k2_[currentIndex],
+                 k3 = k3_[currentIndex], k4 = k4_[currentIndex];
+    for(std::size_t p = 0; p < nbPaths; p++)
+    {
+        nextValues[p] = currentValues[p] + drift
+                        +k1*currentVariances[p] + k2*nextVariances[p]
+                        +std::sqrt(k3*currentVariances[p] + k4*nextVariances[p])*randomVariables[p];
+    }
+}
+
+
+GammaExpansionScheme::GammaExpansionScheme(const NoncentralChiSquareScheme& variancePathSimulator,
+                                           std::size_t nbTerms):
+        HestonLogSpotPathSimulator(variancePathSimulator),
+        nbTerms_(nbTerms)
+{
+    preComputations();
+}
+
+GammaExpansionScheme::GammaExpansionScheme(const GammaExpansionScheme& gammaExpansionScheme):
+        HestonLogSpotPathSimulator(*gammaExpansionScheme.variancePathSimulator_),
+        nbTerms_(gammaExpansionScheme.nbTerms_),
+        k0_(gammaExpansionScheme.k0_),
+        rhoOverEps_(gammaExpansionScheme.rhoOverEps_),
+        integratedVarianceCoefficient_(gammaExpansionScheme.integratedVarianceCoefficient_),
+        oneMinusRhoSquared_(gammaExpansionScheme.oneMinusRhoSquared_),
+        halfDegreesOfFreedom_(gammaExpansionScheme.halfDegreesOfFreedom_),
+        inverseGammas_(gammaExpansionScheme.inverseGammas_),
+        poissonRates_(gammaExpansionScheme.poissonRates_),
+        besselArgumentFactors_(gammaExpansionScheme.besselArgumentFactors_),
+        remainderPoissonMeans_(gammaExpansionScheme.remainderPoissonMeans_),
+        remainderPoissonVariances_(gammaExpansionScheme.remainderPoissonVariances_),
+        remainderGammaMeans_(gammaExpansionScheme.remainderGammaMeans_),
+        remainderGammaVariances_(gammaExpansionScheme.remainderGammaVariances_)
+{
+
+}
+
+void GammaExpansionScheme::preComputations()
+{
+    HestonModel hestonModel = variancePathSimulator_->getHestonModel();
+    double rho = hestonModel.getCorrelation();
+    double theta = hestonModel.getMeanReversionLevel();
+    double kappa = hestonModel.getMeanReversionSpeed();
+    double eps = hestonModel.getVolOfVol();
+    double drift = hestonModel.getDrift();
+    rhoOverEps_ = rho/eps;
+    integratedVarianceCoefficient_ = kappa*rho/eps - 0.5;
+    oneMinusRhoSquared_ = 1. - rho*rho;
+    halfDegreesOfFreedom_ = 2*kappa*theta/(eps*eps);
+
+    /*With a = kappa dt/(2 pi), 1/gamma_n = eps² dt²/(2 pi²)/(n²+a²) and lambda_n/gamma_n = 2 dt/pi² n²/(n²+a²)².
+    The remainders are summed up to nbTerms_+remainderNbTerms, the terms beyond being replaced by the integrals
+    of their equivalents in 1/n² and 1/n^4 (the closed forms of the whole series lose their accuracy to
+    cancellations for small kappa dt) */
+    const std::size_t remainderNbTerms = 256;
+    for(std::size_t i = 0; i < timePoints_.size()-1; i++)
+    {
+        double delta = timePoints_[i+1] - timePoints_[i];
+        k0_.push_back(drift*delta - rho*kappa*theta*delta/eps);
+        besselArgumentFactors_.push_back(2*kappa/(eps*eps*std::sinh(0.5*kappa*delta)));
+
+        double a = kappa*delta/(2*M_PI);
+        double gammaFactor = eps*eps*delta*delta/(2*M_PI*M_PI);
+        double poissonFactor = 2*delta/(M_PI*M_PI);
+        for(std::size_t n = 1; n <= nbTerms_; n++)
+        {
+            double inverseGamma = gammaFactor/(n*n + a*a);
+            inverseGammas_.push_back(inverseGamma);
+            poissonRates_.push_back(poissonFactor*n*n/((n*n + a*a)*(n*n + a*a))/inverseGamma);
+        }
+
+        double poissonMean = 0., poissonVariance = 0., gammaMean = 0., gammaVariance = 0.;
+        for(std::size_t n = nbTerms_+1; n <= nbTerms_+remainderNbTerms; n++)
+        {
+            double inverseGamma = gammaFactor/(n*n + a*a);
+            double poissonTerm = poissonFactor*n*n/((n*n + a*a)*(n*n + a*a));
+            poissonMean += poissonTerm;
+            poissonVariance += 2*poissonTerm*inverseGamma;
+            gammaMean += inverseGamma;
+            gammaVariance += inverseGamma*inverseGamma;
+        }
+        double x = nbTerms_ + remainderNbTerms + 0.5;
+        remainderPoissonMeans_.push_back(poissonMean + poissonFactor/x);
+        remainderPoissonVariances_.push_back(poissonVariance + 2*poissonFactor*gammaFactor/(3*x*x*x));
+        remainderGammaMeans_.push_back(gammaMean + gammaFactor/x);
+        remainderGammaVariances_.push_back(gammaVariance + gammaFactor*gammaFactor/(3*x*x*x));
+    }
+}
+
+GammaExpansionScheme* GammaExpansionScheme::clone() const
+{
+    return new GammaExpansionScheme(*this);
+}
+
+GammaExpansionScheme* GammaExpansionScheme::cloneWithModel(const HestonModel& hestonModel) const
+{
+    NoncentralChiSquareScheme variancePathSimulator(timePoints_, hestonModel);
+    return new GammaExpansionScheme(variancePathSimulator, nbTerms_);
+}
+
+double GammaExpansionScheme::integratedVariance(std::size_t currentIndex, double currentVariance,
+                                                double nextVariance, RandomStream& stream) const
+{
+    double besselArgument = besselArgumentFactors_[currentIndex]*std::sqrt(currentVariance*nextVariance);
+    std::size_t eta = MathFunctions::simulateBesselRandomVariable(halfDegreesOfFreedom_ - 1., besselArgument, stream);
+    double shape = halfDegreesOfFreedom_ + 2.*eta;
+    double varianceSum = currentVariance + nextVariance;
+
+    //Terms drawn exactly, the gamma variables of the three series of Glasserman and Kim being summed
+    double integral = 0.;
+    const double* inverseGammas = &inverseGammas_[currentIndex*nbTerms_];
+    const double* poissonRates = &poissonRates_[currentIndex*nbTerms_];
+    for(std::size_t n = 0; n < nbTerms_; n++)
+    {
+        std::size_t N = MathFunctions::simulatePoissonRandomVariable(varianceSum*poissonRates[n], stream);
+        integral += MathFunctions::simulateGammaRandomVariable(shape + N, stream)*inverseGammas[n];
+    }
+
+    //Rest of the series, replaced by a gamma variable with its mean and variance
+    double mean = varianceSum*remainderPoissonMeans_[currentIndex] + shape*remainderGammaMeans_[currentIndex];
+    double variance = varianceSum*remainderPoissonVariances_[currentIndex]
+                      + shape*remainderGammaVariances_[currentIndex];
+    integral += MathFunctions::simulateGammaRandomVariable(mean*mean/variance, stream)*variance/mean;
+    return integral;
+}
+
+double GammaExpansionScheme::nextStep(std::size_t currentIndex, double currentValue,
+                                      const std::vector<double>& variancePath, double randomVariable,
+                                      RandomStream& stream) const
+{
+    double nextValue;
+    nextStepBlock(currentIndex, &currentValue, &variancePath[currentIndex], &variancePath[currentIndex+1],
+                  &randomVariable, &nextValue, 1, &stream);
+    return nextValue;
+}
+
+RandomVariableType GammaExpansionScheme::getRandomVariableType() const
+{
+    return RandomVariableType::Gaussian;
+}
+
+bool GammaExpansionScheme::drawsAdditionalRandomVariables() const
+{
+    return true;
+}
+
+void GammaExpansionScheme::nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                                         const double* currentVariances, const double* nextVariances,
+                                         const double* randomVariables, double* nextValues,
+                                         std::size_t nbPaths, RandomStream* streams) const
+{
+    const double k0 = k0_[currentIndex];
+    for(std::size_t p = 0; p < nbPaths; p++)
+    {
+        RandomStream& stream = streams ? streams[p] : MathFunctions::generator;
+        double integral = integratedVariance(currentIndex, currentVariances[p], nextVariances[p], stream);
+        nextValues[p] = currentValues[p] + k0
+                        + rhoOverEps_*(nextVariances[p] - currentVariances[p])
+                        + integratedVarianceCoefficient_*integral
+                        + std::sqrt(oneMinusRhoSquared_*integral)*randomVariables[p];
+    }
+}
@@ -9,7 +9,10 @@ class HestonLogSpotPathSimulator : public PathSimulator
 {
 protected:
     const HestonVariancePathSimulator* variancePathSimulator_;
-    virtual double nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath) const = 0;
+    /*Method advancing the log-spot by one step, given a pre-drawn random variable of type getRandomVariableType().
+    The additional random variables of the step, if any, are drawn from stream */
+    virtual double nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath,
+                            double randomVariable, RandomStream& stream) const = 0;
 public:
     HestonLogSpotPathSimulator(const HestonVariancePathSimulator& variancePathSimulator);
 
@@ -19,17 +22,49 @@ public:
     HestonLogSpotPathSimulator& operator=(const HestonLogSpotPathSimulator& logSpotPathSimulator);
 
     virtual HestonLogSpotPathSimulator* clone() const =0;
-    std::vector<double> path() const;
+    /*Method returning a copy of the scheme, with the same time points and settings for the log-spot
+    and the variance, simulating hestonModel */
+    virtual HestonLogSpotPathSimulator* cloneWithModel(const HestonModel& hestonModel) const =0;
+    HestonModel getHestonModel() const;
+    std::vector<double> path(RandomStream& stream = MathFunctions::generator) const;
+    /*The variance of the block is not stored : only its values at the current and next time
+    points are kept, in two contiguous arrays */
+    std::vector<double> pathBlock(RandomVariablesGenerator& randomVariablesGenerator) const;
+    /*Method simulating randomVariablesGenerator.getNbPaths() paths and returning, for each of them, the sum of the squared log-returns between consecutive observation indexes (sorted
+    indexes of timePoints_).
+    The paths are advanced in place and the squared log-returns are accumulated when an
+    observation index is crossed, so that the memory used per path doesn't depend on the
+    number of time points.
+    If integratedVariances is not null, it is filled with the trapezoidal integrals of the
+    variance paths between the first and the last observation indexes */
+    std::vector<double> sumOfSquaredLogReturns(RandomVariablesGenerator& randomVariablesGenerator,
+                                               const std::vector<std::size_t>& observationIndexes,
+                                               std::vector<double>* integratedVariances = nullptr) const;
+
+    //Distribution of the random variables consumed by nextStepBlock
+    virtual RandomVariableType getRandomVariableType() const = 0;
+    /*Method advancing nbPaths log-spot values from time index currentIndex to currentIndex+1,
+    given the variances of the paths at both time points and one pre-drawn random variable per path.
+    If drawsAdditionalRandomVariables(), the additional random variables of the path p are drawn from streams[p],
+    or from MathFunctions::generator if streams is null */
+    virtual void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                               const double* currentVariances, const double* nextVariances,
+                               const double* randomVariables, double* nextValues,
+                               std::size_t nbPaths, RandomStream* streams = nullptr) const = 0;
 };
 
 class BroadieKayaScheme : public HestonLogSpotPathSimulator{
 private:
-    double nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath) const;
+    double nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath,
+                    double randomVariable, RandomStream& stream) const;
     
     //Coefficients used for the approximation of the integral of V
     double gamma1_;
     double gamma2_;
 
+    //Drift of the log-spot, cached to avoid copying the model at each step
+    double drift_;
+
     //Pre-computed coefficients of the diffusion that are path independent
     std::vector<double>  k0_;
     std::vector<double>  k1_;
@@ -46,6 +81,70 @@ public:
     BroadieKayaScheme(const BroadieKayaScheme& broadieKayaScheme);
     ~BroadieKayaScheme() = default;
     BroadieKayaScheme* clone() const;
+    BroadieKayaScheme* cloneWithModel(const HestonModel& hestonModel) const;
+
+    RandomVariableType getRandomVariableType() const;
+    void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                       const double* currentVariances, const double* nextVariances,
+                       const double* randomVariables, double* nextValues,
+                       std::size_t nbPaths, RandomStream* streams = nullptr) const;
+};
+
+/*Exact simulation of the log-spot (Broadie and Kaya), for steps of any size :
+X(t+dt) = X(t) + drift dt + rho/eps (V(t+dt) - V(t) - kappa theta dt) + (kappa rho/eps - 1/2) I + sqrt((1-rho²) I) Z
+where I is the integral of the variance over the step, drawn given V(t) and V(t+dt) by the gamma expansion of
+Glasserman and Kim (2011) :
+I = sum over n >= 1 of Gamma(N_n + delta/2 + 2 eta)/gamma_n, N_n Poisson of mean (V(t)+V(t+dt)) lambda_n and
+eta of Bessel distribution. The nbTerms first terms are drawn, and the rest of the series is replaced by a gamma
+variable with the same mean and variance.
+With the exact variance of NoncentralChiSquareScheme, the paths can jump from one observation date to the next,
+without discretization bias. I is drawn from the auxiliary stream of the path for the step */
+class GammaExpansionScheme : public HestonLogSpotPathSimulator
+{
+private:
+    double nextStep(std::size_t currentIndex, double currentValue, const std::vector<double>& variancePath,
+                    double randomVariable, RandomStream& stream) const;
+
+    //Number of terms of the series drawn exactly
+    std::size_t nbTerms_;
+
+    //Coefficients of the step, k0 including the drift
+    std::vector<double> k0_;
+    double rhoOverEps_;
+    double integratedVarianceCoefficient_;
+    double oneMinusRhoSquared_;
+
+    //Half of the degrees of freedom of the variance delta/2, index delta/2-1 of the Bessel distribution
+    double halfDegreesOfFreedom_;
+    /*For each step, 1/gamma_n and lambda_n of the terms drawn exactly, stored as inverseGammas_[i*nbTerms_+n-1],
+    and factor of sqrt(V(t) V(t+dt)) giving the argument of the Bessel distribution */
+    std::vector<double> inverseGammas_;
+    std::vector<double> poissonRates_;
+    std::vector<double> besselArgumentFactors_;
+    /*For each step, sums over the remaining terms of lambda_n/gamma_n, 2 lambda_n/gamma_n², 1/gamma_n and
+    1/gamma_n², giving the mean and variance of the rest of the series */
+    std::vector<double> remainderPoissonMeans_;
+    std::vector<double> remainderPoissonVariances_;
+    std::vector<double> remainderGammaMeans_;
+    std::vector<double> remainderGammaVariances_;
+
+    void preComputations();
+    //Integral of the variance over the step currentIndex, given its values at both ends
+    double integratedVariance(std::size_t currentIndex, double currentVariance, double nextVariance,
+                              RandomStream& stream) const;
+public:
+    GammaExpansionScheme(const NoncentralChiSquareScheme& variancePathSimulator, std::size_t nbTerms = 5);
+    GammaExpansionScheme(const GammaExpansionScheme& gammaExpansionScheme);
+    ~GammaExpansionScheme() = default;
+    GammaExpansionScheme* clone() const;
+    GammaExpansionScheme* cloneWithModel(const HestonModel& hestonModel) const;
+
+    RandomVariableType getRandomVariableType() const;
+    bool drawsAdditionalRandomVariables() const;
+    void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                       const double* currentVariances, const double* nextVariances,
+                       const double* randomVariables, double* nextValues,
+                       std::size_t nbPaths, RandomStream* streams = nullptr) const;
 };
 
 
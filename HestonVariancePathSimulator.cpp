@@ -2,7 +2,12 @@
 #include <algorithm>
 #include <iostream>
 #include "HestonVariancePathSimulator.h"
+#include "Instrumentation.h"
 #include "MathFunctions.h"
+#include "RandomVariablesGenerator.h"
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
 
 HestonVariancePathSimulator::HestonVariancePathSimulator(
         const std::vector<double>& timePoints,
@@ -65,15 +70,34 @@ void HestonVariancePathSimulator::preComputations()
     }
 }
 
-std::vector<double> HestonVariancePathSimulator::path() const
+std::vector<double> HestonVariancePathSimulator::path(RandomStream& stream) const
 {
     std::vector<double> path {initialValue_};
+    RandomVariableType randomVariableType = getRandomVariableType();
     for (std::size_t index = 0; index < timePoints_.size() - 1; ++index)
-        path.push_back(nextStep(index, path[index]));
+        path.push_back(nextStep(index, path[index],
+                                simulateRandomVariable(randomVariableType, stream), stream));
 
     return path;
 }
 
+std::vector<double> HestonVariancePathSimulator::pathBlock(RandomVariablesGenerator& randomVariablesGenerator) const
+{
+    std::size_t nbPaths = randomVariablesGenerator.getNbPaths();
+    std::vector<double> pathBlock(timePoints_.size()*nbPaths, initialValue_);
+    std::vector<double> randomVariables(nbPaths);
+    RandomVariableType randomVariableType = getRandomVariableType();
+    bool drawsAdditionalRandomVariables = this->drawsAdditionalRandomVariables();
+    for (std::size_t index = 0; index < timePoints_.size() - 1; ++index)
+    {
+        randomVariablesGenerator.simulateRandomVariables(index, 0, randomVariableType, randomVariables.data());
+        nextStepBlock(index, &pathBlock[index*nbPaths], randomVariables.data(),
+                      &pathBlock[(index+1)*nbPaths], nbPaths,
+                      drawsAdditionalRandomVariables ? randomVariablesGenerator.auxiliaryStreams(index, 0) : nullptr);
+    }
+    return pathBlock;
+}
+
 HestonModel HestonVariancePathSimulator::getHestonModel() const
 {
     return *hestonModel_;
@@ -86,19 +110,20 @@ TruncatedGaussianScheme::TruncatedGaussianScheme(const std::vector<double>& time
                                                  double initialGuess):
     HestonVariancePathSimulator(timePoints,hestonModel),
     confidenceMultiplier_(confidenceMultiplier),
-    psiGrid_(std::vector<double>(psiGridSize)),
-    initialGuess_(initialGuess)
+    psiGridSize_(psiGridSize),
+    initialGuess_(initialGuess),
+    momentFittingTable_(preComputationsTG())
 {
-    preComputationsTG();
+
 }
 
 TruncatedGaussianScheme::TruncatedGaussianScheme(const TruncatedGaussianScheme& truncatedGaussianScheme):
     HestonVariancePathSimulator(truncatedGaussianScheme.timePoints_,
                                 *truncatedGaussianScheme.hestonModel_),
     confidenceMultiplier_(truncatedGaussianScheme.confidenceMultiplier_),
-    psiGrid_(truncatedGaussianScheme.psiGrid_),
+    psiGridSize_(truncatedGaussianScheme.psiGridSize_),
     initialGuess_(truncatedGaussianScheme.initialGuess_),
-    fmu_(truncatedGaussianScheme.fmu_), fsigma_(truncatedGaussianScheme.fsigma_)
+    momentFittingTable_(truncatedGaussianScheme.momentFittingTable_)
 {
     
 }
@@ -108,60 +133,153 @@ TruncatedGaussianScheme* TruncatedGaussianScheme::clone() const
     return new TruncatedGaussianScheme(*this);
 }
 
-void TruncatedGaussianScheme::preComputationsTG()
+TruncatedGaussianScheme* TruncatedGaussianScheme::cloneWithModel(const HestonModel& hestonModel) const
+{
+    //The range of psi depends on the model, so that a table of the scheme is rebuilt by the constructor
+    return new TruncatedGaussianScheme(timePoints_, hestonModel, confidenceMultiplier_,
+                                       psiGridSize_, initialGuess_);
+}
+
+std::shared_ptr<const LookupTable> TruncatedGaussianScheme::preComputationsTG() const
 {
     double theta = hestonModel_->getMeanReversionLevel();
     double kappa = hestonModel_->getMeanReversionSpeed();
     double eps = hestonModel_->getVolOfVol();
 
-    //We first construct a grid for psi 
-    double min = 1.0/(confidenceMultiplier_*confidenceMultiplier_);
-    double max = eps*eps/(2*kappa*theta);
-    psiGrid_ = MathFunctions::buildLinearSpace(min,max,psiGrid_.size());
-    double r, psi, phi, Phi;
-    for(std::size_t i = 0; i < psiGrid_.size(); i++)
+    //psi is at most eps²/(2 kappa theta), reached when the current variance is 0
+    double min = 1.0/confidenceMultiplier_;
+    double max = eps/std::sqrt(2*kappa*theta);
+    std::shared_ptr<const LookupTable> sharedTable = sharedMomentFittingTable();
+    if(psiGridSize_ == 0 && sharedTable->getMin() <= min && max <= sharedTable->getMax())
+        return sharedTable;
+
+    /*Table of the scheme, with 32 nodes by default, which is more accurate than 100 nodes with linear
+    interpolation in psi. It is kept non-empty when the moment-fitting step is never taken */
+    double initialGuess = initialGuess_;
+    return std::make_shared<LookupTable>([initialGuess](double sqrtPsi, double* values)
+    {
+        momentFittingFunctions(sqrtPsi, initialGuess, values);
+    }, 2, min, std::max(max, 2*min), psiGridSize_ > 0 ? psiGridSize_ : 32);
+}
+
+void TruncatedGaussianScheme::momentFittingFunctions(double sqrtPsi, double initialGuess, double* values)
+{
+    //When psi goes to 0, the truncation doesn't change the moments anymore
+    if(sqrtPsi <= 0.)
     {
-        psi = psiGrid_[i];
-        //We look for r that nullifies the function h by using a Newton method
-        r = MathFunctions::newtonMethod(initialGuess_,
-                                        [psi](double r){return h(r,psi);},
-                                        [psi](double r){return hPrime(r,psi);});
-        phi = MathFunctions::normalPDF(r);
-        Phi = MathFunctions::normalCDF(r);
-        fmu_.push_back(r/(phi+r*Phi));
-        fsigma_.push_back(pow(psi,-0.5)/(phi+r*Phi));
+        values[0] = values[1] = 1.;
+        return;
     }
+    /*We look for r that nullifies the function h by using a Newton method. For small psi, r is close to
+    1/sqrt(psi), and the method would converge to a spurious root from a smaller initial guess */
+    double psi = sqrtPsi*sqrtPsi;
+    double r = MathFunctions::newtonMethod(std::max(initialGuess, 1./sqrtPsi),
+                                           [psi](double r){return h(r,psi);},
+                                           [psi](double r){return hPrime(r,psi);},
+                                           1e-12);
+    double phi = MathFunctions::normalPDF(r);
+    double Phi = MathFunctions::normalCDF(r);
+    values[0] = r/(phi+r*Phi);
+    values[1] = 1./(sqrtPsi*(phi+r*Phi));
 }
 
-double TruncatedGaussianScheme::nextStep(std::size_t currentIndex, double currentValue) const
+std::shared_ptr<const LookupTable> TruncatedGaussianScheme::sharedMomentFittingTable()
+{
+    /*sqrt(psi) from 0 to 128, i.e. confidence multipliers of any size and models whose Feller ratio
+    2 kappa theta/eps² is above 6e-5, with a step of 1/8 (64 kB, built in a few ms). A given model
+    only reads the intervals below its largest psi, e.g. 2 kB for the case I */
+    static const std::shared_ptr<const LookupTable> table = std::make_shared<LookupTable>(
+                                                                [](double sqrtPsi, double* values)
+    {
+        momentFittingFunctions(sqrtPsi, 1., values);
+    }, 2, 0., 128., 1025);
+    return table;
+}
+
+double TruncatedGaussianScheme::nextStep(std::size_t currentIndex, double currentValue,
+                                         double randomVariable, RandomStream& /*stream*/) const
 {
     //We used the pre-computed coefficients to compute m and s²
     double m = k1_[currentIndex]*currentValue + k2_[currentIndex];
     double s2 = k3_[currentIndex]*currentValue + k4_[currentIndex];
-    double psi = s2/(m*m);
+    double s = sqrt(s2);
+    double sqrtPsi = s/m;
     double mu, sigma;
 
     //If psi is close to 0, we skip the moment-fitting step
-    if(psi < 1.0/(confidenceMultiplier_*confidenceMultiplier_))
+    if(sqrtPsi < 1.0/confidenceMultiplier_)
     {
+        INSTRUMENT_COUNT(TruncatedGaussianSkip, 1);
         mu = m;
-        sigma = sqrt(s2);
+        sigma = s;
     }
     else 
     {   
-        //We look for i such that psiGrid_[i] <= psi < psiGrid_[i+1]
-        std::size_t idxPhi = MathFunctions::binarySearch(psiGrid_,psi);
-        double psi0 = psiGrid_[idxPhi], psi1 = psiGrid_[idxPhi+1];
-        //Linear interpolation of fmu and fsigma using the pre-computed values
-        double fmu = (fmu_[idxPhi]*(psi1-psi)+fmu_[idxPhi+1]*(psi-psi0))/(psi1-psi0);
-        double fsigma = (fsigma_[idxPhi]*(psi1-psi)+fsigma_[idxPhi+1]*(psi-psi0))/(psi1-psi0);
-        mu = fmu*m;
-        sigma = fsigma*sqrt(s2);
+        INSTRUMENT_COUNT(TruncatedGaussianMomentFitting, 1);
+        //f_mu and f_sigma are interpolated in the pre-computed table
+        double f[2];
+        momentFittingTable_->evaluate<2>(sqrtPsi, f);
+        mu = f[0]*m;
+        sigma = f[1]*s;
     }
-    double z = MathFunctions::simulateGaussianRandomVariable();
-    return std::max(mu+sigma*z,0.0);
+    return std::max(mu+sigma*randomVariable,0.0);
 }   
 
+RandomVariableType TruncatedGaussianScheme::getRandomVariableType() const
+{
+    return RandomVariableType::Gaussian;
+}
+
+void TruncatedGaussianScheme::nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                                            const double* randomVariables, double* nextValues,
+                                            std::size_t nbPaths, RandomStream* /*streams*/) const
+{
+    const double k1 = k1_[currentIndex], k2 = k2_[currentIndex],
+                 k3 = k3_[currentIndex], k4 = k4_[currentIndex];
+    const double sqrtPsiThreshold = 1.0/confidenceMultiplier_;
+    std::size_t p = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    /*Branchless step on 4 paths at once : the coefficients are looked up for all the paths, and replaced by 1
+    on the paths skipping the moment-fitting step */
+    const __m256d ones = _mm256_set1_pd(1.);
+    for(; p + 4 <= nbPaths; p += 4)
+    {
+        __m256d V = _mm256_loadu_pd(currentValues + p);
+        __m256d m = _mm256_fmadd_pd(_mm256_set1_pd(k1), V, _mm256_set1_pd(k2));
+        __m256d s = _mm256_sqrt_pd(_mm256_fmadd_pd(_mm256_set1_pd(k3), V, _mm256_set1_pd(k4)));
+        __m256d sqrtPsi = _mm256_div_pd(s, m);
+        __m256d isFitted = _mm256_cmp_pd(sqrtPsi, _mm256_set1_pd(sqrtPsiThreshold), _CMP_GE_OQ);
+        INSTRUMENT_COUNT(TruncatedGaussianMomentFitting, __builtin_popcount(_mm256_movemask_pd(isFitted)));
+        INSTRUMENT_COUNT(TruncatedGaussianSkip, 4 - __builtin_popcount(_mm256_movemask_pd(isFitted)));
+
+        __m256d f[2];
+        momentFittingTable_->evaluate<2>(sqrtPsi, f);
+        __m256d mu = _mm256_mul_pd(_mm256_blendv_pd(ones, f[0], isFitted), m);
+        __m256d sigma = _mm256_mul_pd(_mm256_blendv_pd(ones, f[1], isFitted), s);
+        __m256d next = _mm256_fmadd_pd(sigma, _mm256_loadu_pd(randomVariables + p), mu);
+        _mm256_storeu_pd(nextValues + p, _mm256_max_pd(next, _mm256_setzero_pd()));
+    }
+#endif
+    //Scalar loop, for the last paths of the block or without AVX2
+    for(; p < nbPaths; p++)
+    {
+        double m = k1*currentValues[p] + k2;
+        double s = std::sqrt(k3*currentValues[p] + k4);
+        double sqrtPsi = s/m;
+        double f[2] = {1., 1.};
+
+        //Same moment-fitting step as nextStep
+        if(sqrtPsi >= sqrtPsiThreshold)
+        {
+            INSTRUMENT_COUNT(TruncatedGaussianMomentFitting, 1);
+            momentFittingTable_->evaluate<2>(sqrtPsi, f);
+        }
+        else
+            INSTRUMENT_COUNT(TruncatedGaussianSkip, 1);
+        nextValues[p] = std::max(f[0]*m+f[1]*s*randomVariables[p],0.0);
+    }
+}
+
 double TruncatedGaussianScheme::h(double r, double psi)
 {
     double phi = MathFunctions::normalPDF(r);
@@ -200,15 +318,22 @@ QuadraticExponentialScheme* QuadraticExponentialScheme::clone() const
     return new QuadraticExponentialScheme(*this);
 }
 
-double QuadraticExponentialScheme::nextStep(std::size_t currentIndex, double currentValue) const{
+QuadraticExponentialScheme* QuadraticExponentialScheme::cloneWithModel(const HestonModel& hestonModel) const
+{
+    return new QuadraticExponentialScheme(timePoints_, hestonModel, psiC_);
+}
+
+double QuadraticExponentialScheme::nextStep(std::size_t currentIndex, double currentValue,
+                                            double randomVariable, RandomStream& /*stream*/) const{
     
     //We used the pre-computed coefficients to compute m and s²
     double m = k1_[currentIndex]*currentValue + k2_[currentIndex];
     double s2 = k3_[currentIndex]*currentValue + k4_[currentIndex];
     double psi = s2/(m*m);
-    double U = MathFunctions::simulateUniformRandomVariable();
+    double U = randomVariable;
 
     if (psi<psiC_){
+        INSTRUMENT_COUNT(QuadraticExponentialQuadratic, 1);
         double temp_value = 2./psi;
         double b = std::sqrt(temp_value - 1. + std::sqrt(temp_value*(temp_value-1.)));
         double a = m/(1+b*b);
@@ -219,6 +344,7 @@ double QuadraticExponentialScheme::nextStep(std::size_t currentIndex, double cur
         return a*(b+Zv)*(b+Zv);
     }
     else {
+        INSTRUMENT_COUNT(QuadraticExponentialExponential, 1);
         double p = (psi-1.)/(psi+1.);
         if (U<=p){
             return 0.;
@@ -230,3 +356,176 @@ double QuadraticExponentialScheme::nextStep(std::size_t currentIndex, double cur
     }
 }
 
+RandomVariableType QuadraticExponentialScheme::getRandomVariableType() const
+{
+    return RandomVariableType::Uniform;
+}
+
+void QuadraticExponentialScheme::nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                                               const double* randomVariables, double* nextValues,
+                                               std::size_t nbPaths, RandomStream* /*streams*/) const
+{
+    const double k1 = k1_[currentIndex], k2 = k2_[currentIndex],
+                 k3 = k3_[currentIndex], k4 = k4_[currentIndex];
+    //The Gaussian variables of the quadratic branch are computed at once by the vectorized inverse cdf
+    std::vector<double> Zv(nbPaths);
+    MathFunctions::normalCDFInverse(randomVariables, Zv.data(), nbPaths);
+    std::size_t p = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    /*Branchless step on 4 paths at once. The exponential branch is written scale*log(argument), the scale being 0
+    (and the argument 1) on the paths of the quadratic branch and on those below the mass at 0 : the logarithms
+    are computed afterwards for all the paths by the vectorized logarithm, and added to the quadratic values.
+    Divisions and square roots are what limit this loop, so the branches share them : psi and 2/psi come from the
+    same inverse, and a = m/(1+b²) and the argument of the logarithm are computed by a single blended division */
+    const std::size_t nbVectorizedPaths = nbPaths - nbPaths%4;
+    std::vector<double> exponentialScales(nbVectorizedPaths), logArguments(nbVectorizedPaths);
+    const __m256d ones = _mm256_set1_pd(1.), twos = _mm256_set1_pd(2.);
+    for(; p < nbVectorizedPaths; p += 4)
+    {
+        __m256d V = _mm256_loadu_pd(currentValues + p);
+        __m256d m = _mm256_fmadd_pd(_mm256_set1_pd(k1), V, _mm256_set1_pd(k2));
+        __m256d m2 = _mm256_mul_pd(m, m);
+        __m256d s2 = _mm256_fmadd_pd(_mm256_set1_pd(k3), V, _mm256_set1_pd(k4));
+        __m256d inverse = _mm256_div_pd(ones, _mm256_mul_pd(s2, m2));
+        __m256d psi = _mm256_mul_pd(_mm256_mul_pd(s2, s2), inverse);
+        __m256d U = _mm256_loadu_pd(randomVariables + p);
+        __m256d isQuadratic = _mm256_cmp_pd(psi, _mm256_set1_pd(psiC_), _CMP_LT_OQ);
+        INSTRUMENT_COUNT(QuadraticExponentialQuadratic, __builtin_popcount(_mm256_movemask_pd(isQuadratic)));
+        INSTRUMENT_COUNT(QuadraticExponentialExponential, 4 - __builtin_popcount(_mm256_movemask_pd(isQuadratic)));
+
+        //Quadratic branch (NaN on the paths of the exponential branch, where it is discarded)
+        __m256d temp_value = _mm256_mul_pd(_mm256_mul_pd(twos, _mm256_mul_pd(m2, m2)), inverse);
+        __m256d b = _mm256_sqrt_pd(_mm256_add_pd(_mm256_sub_pd(temp_value, ones),
+                                   _mm256_sqrt_pd(_mm256_mul_pd(temp_value, _mm256_sub_pd(temp_value, ones)))));
+
+        /*Exponential branch, with 1-p0 = 2/(psi+1) : U > p0 when U*(psi+1) > psi-1, the scale m/(1-p0)
+        is m*(psi+1)/2 and the argument (1-p0)/(1-U) is 2/((psi+1)*(1-U)) */
+        __m256d psiPlusOne = _mm256_add_pd(psi, ones);
+        __m256d isExponential = _mm256_andnot_pd(isQuadratic, _mm256_cmp_pd(_mm256_mul_pd(U, psiPlusOne),
+                                                                            _mm256_sub_pd(psi, ones), _CMP_GT_OQ));
+        _mm256_storeu_pd(&exponentialScales[p], _mm256_and_pd(_mm256_mul_pd(_mm256_mul_pd(m, psiPlusOne),
+                                                                            _mm256_set1_pd(0.5)), isExponential));
+
+        //a on the paths of the quadratic branch, argument of the logarithm on the others
+        __m256d quotient = _mm256_div_pd(_mm256_blendv_pd(twos, m, isQuadratic),
+                                         _mm256_blendv_pd(_mm256_mul_pd(psiPlusOne, _mm256_sub_pd(ones, U)),
+                                                          _mm256_fmadd_pd(b, b, ones), isQuadratic));
+        _mm256_storeu_pd(&logArguments[p], _mm256_blendv_pd(ones, quotient, isExponential));
+        __m256d bPlusZ = _mm256_add_pd(b, _mm256_loadu_pd(&Zv[p]));
+        _mm256_storeu_pd(nextValues + p, _mm256_and_pd(_mm256_mul_pd(_mm256_mul_pd(quotient, bPlusZ), bPlusZ),
+                                                       isQuadratic));
+    }
+    MathFunctions::logarithm(logArguments.data(), logArguments.data(), nbVectorizedPaths);
+    for(std::size_t q = 0; q < nbVectorizedPaths; q++)
+        nextValues[q] += exponentialScales[q]*logArguments[q];
+#endif
+    //Scalar loop, for the last paths of the block or without AVX2
+    for(; p < nbPaths; p++)
+    {
+        double m = k1*currentValues[p] + k2;
+        double s2 = k3*currentValues[p] + k4;
+        double psi = s2/(m*m);
+        double U = randomVariables[p];
+
+        //Same quadratic and exponential branches as nextStep
+        if (psi<psiC_){
+            INSTRUMENT_COUNT(QuadraticExponentialQuadratic, 1);
+            double temp_value = 2./psi;
+            double b = std::sqrt(temp_value - 1. + std::sqrt(temp_value*(temp_value-1.)));
+            double a = m/(1+b*b);
+            nextValues[p] = a*(b+Zv[p])*(b+Zv[p]);
+        }
+        else {
+            INSTRUMENT_COUNT(QuadraticExponentialExponential, 1);
+            double p0 = (psi-1.)/(psi+1.);
+            nextValues[p] = U<=p0 ? 0. : std::log((1-p0)/(1-U))*m/(1-p0);
+        }
+    }
+}
+
+
+NoncentralChiSquareScheme::NoncentralChiSquareScheme(const std::vector<double>& timePoints,
+                                                     const HestonModel& hestonModel):
+    HestonVariancePathSimulator(timePoints,hestonModel)
+{
+    preComputationsNCX2();
+}
+
+NoncentralChiSquareScheme::NoncentralChiSquareScheme(const NoncentralChiSquareScheme& noncentralChiSquareScheme):
+    HestonVariancePathSimulator(noncentralChiSquareScheme.timePoints_,
+                                *noncentralChiSquareScheme.hestonModel_),
+    halfDegreesOfFreedom_(noncentralChiSquareScheme.halfDegreesOfFreedom_),
+    gammaScales_(noncentralChiSquareScheme.gammaScales_),
+    poissonMeanFactors_(noncentralChiSquareScheme.poissonMeanFactors_)
+{
+
+}
+
+NoncentralChiSquareScheme* NoncentralChiSquareScheme::clone() const
+{
+    return new NoncentralChiSquareScheme(*this);
+}
+
+NoncentralChiSquareScheme* NoncentralChiSquareScheme::cloneWithModel(const HestonModel& hestonModel) const
+{
+    return new NoncentralChiSquareScheme(timePoints_, hestonModel);
+}
+
+void NoncentralChiSquareScheme::preComputationsNCX2()
+{
+    double theta = hestonModel_->getMeanReversionLevel();
+    double kappa = hestonModel_->getMeanReversionSpeed();
+    double eps = hestonModel_->getVolOfVol();
+    halfDegreesOfFreedom_ = 2*kappa*theta/(eps*eps);
+
+    for(std::size_t i = 0; i < timePoints_.size()-1; i++)
+    {
+        double expMinusKappaDelta = std::exp(-kappa*(timePoints_[i+1] - timePoints_[i]));
+        double c = eps*eps*(1-expMinusKappaDelta)/(2*kappa);
+        gammaScales_.push_back(c);
+        poissonMeanFactors_.push_back(expMinusKappaDelta/c);
+    }
+}
+
+RandomVariableType NoncentralChiSquareScheme::getRandomVariableType() const
+{
+    return RandomVariableType::Uniform;
+}
+
+bool NoncentralChiSquareScheme::drawsAdditionalRandomVariables() const
+{
+    return true;
+}
+
+double NoncentralChiSquareScheme::nextStep(std::size_t currentIndex, double currentValue,
+                                           double randomVariable, RandomStream& stream) const
+{
+    /*For the usual means, N is the inverse of the Poisson cdf at the uniform of the step, and the position of the
+    uniform inside the jump of the cdf boosts the gamma variable of shape below 1. stream is then only used for a
+    single draw of Marsaglia and Tsang's method */
+    double mean = currentValue*poissonMeanFactors_[currentIndex];
+    std::size_t N;
+    double conditionalUniform;
+    if(mean < maxInversionMean)
+        N = MathFunctions::poissonCDFInverse(mean, randomVariable, &conditionalUniform);
+    else
+    {
+        N = MathFunctions::simulatePoissonRandomVariable(mean, stream);
+        conditionalUniform = stream.nextUniform();
+    }
+
+    double shape = halfDegreesOfFreedom_ + N;
+    if(shape < 1.)
+        return gammaScales_[currentIndex]*MathFunctions::simulateGammaRandomVariable(shape+1., stream)
+               *std::pow(conditionalUniform, 1./shape);
+    return gammaScales_[currentIndex]*MathFunctions::simulateGammaRandomVariable(shape, stream);
+}
+
+void NoncentralChiSquareScheme::nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                                              const double* randomVariables, double* nextValues,
+                                              std::size_t nbPaths, RandomStream* streams) const
+{
+    for(std::size_t p = 0; p < nbPaths; p++)
+        nextValues[p] = nextStep(currentIndex, currentValues[p], randomVariables[p],
+                                 streams ? streams[p] : MathFunctions::generator);
+}
@@ -3,6 +3,8 @@
 
 
 #include "PathSimulator.h"
+#include "LookupTable.h"
+#include <memory>
 
 //Abstract class
 class HestonVariancePathSimulator : public PathSimulator
@@ -11,7 +13,6 @@ protected:
     const HestonModel* hestonModel_;
     /* Function that pre-computes some quantities that will be used in nextStep and caches them */
     void preComputations();
-    virtual double nextStep(std::size_t currentIndex, double currentValue) const = 0;
     std::vector<double> k1_;
     std::vector<double> k2_;
     std::vector<double> k3_;
@@ -27,16 +28,43 @@ public:
                         const HestonVariancePathSimulator& variancePathSimulator);
     
     virtual HestonVariancePathSimulator* clone() const = 0;
-    std::vector<double> path() const;
+    //Method returning a copy of the scheme, with the same time points and settings, simulating hestonModel
+    virtual HestonVariancePathSimulator* cloneWithModel(const HestonModel& hestonModel) const = 0;
+    std::vector<double> path(RandomStream& stream = MathFunctions::generator) const;
+    //The random variables of the variance are those of the factor 0 of the generator
+    std::vector<double> pathBlock(RandomVariablesGenerator& randomVariablesGenerator) const;
     HestonModel getHestonModel() const;
+
+    //Distribution of the random variables consumed by nextStep and nextStepBlock
+    virtual RandomVariableType getRandomVariableType() const = 0;
+    /*Method advancing the variance by one step, given a pre-drawn random variable of type getRandomVariableType().
+    The additional random variables of the step, if any, are drawn from stream. It is the scalar reference of
+    nextStepBlock */
+    virtual double nextStep(std::size_t currentIndex, double currentValue, double randomVariable,
+                            RandomStream& stream = MathFunctions::generator) const = 0;
+    /*Method advancing nbPaths variance values from time index currentIndex to currentIndex+1,
+    using one pre-drawn random variable per path. The arrays are contiguous; with AVX2 the paths are
+    advanced 4 at a time without branches, and the results are those of nextStep up to rounding.
+    If drawsAdditionalRandomVariables(), the additional random variables of the path p are drawn from streams[p],
+    or from MathFunctions::generator if streams is null */
+    virtual void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                               const double* randomVariables, double* nextValues,
+                               std::size_t nbPaths, RandomStream* streams = nullptr) const = 0;
 };
 
 class TruncatedGaussianScheme : public HestonVariancePathSimulator
 {
 private:
-    //Pre-computation of f_mu and f_sigma on psiGrid
-    void preComputationsTG();
-    double nextStep(std::size_t currentIndex, double currentValue) const;
+    /*Pre-computation of the table of f_mu and f_sigma. They are tabulated as functions of sqrt(psi), which
+    spreads the nodes where they vary the most (small psi), and is computed from the standard deviation
+    needed by the step anyway.
+    The functions don't depend on the model : by default, the scheme uses the table shared by all the
+    schemes of the process, and only builds its own table if its range of psi isn't covered */
+    std::shared_ptr<const LookupTable> preComputationsTG() const;
+    //f_mu and f_sigma at sqrt(psi), r being found by a Newton method starting from initialGuess
+    static void momentFittingFunctions(double sqrtPsi, double initialGuess, double* values);
+    //Table shared by all the schemes, built once at its first use
+    static std::shared_ptr<const LookupTable> sharedMomentFittingTable();
 
     /*Function that the r used to compute f_mu and f_sigma must nullifies. 
     It is declared as static since it doesn't need any attribute from the class*/
@@ -49,14 +77,14 @@ private:
     the grid for psi */
     const double confidenceMultiplier_;
 
-    //Grid for psi on which f_mu and f_sigma are computed
-    std::vector<double> psiGrid_;
+    //Number of nodes of the table of f_mu and f_sigma of the scheme, 0 if it uses the shared table
+    std::size_t psiGridSize_;
 
     //Initial guess for r inputed in Newton method
     double initialGuess_;
 
-    std::vector<double> fmu_;
-    std::vector<double> fsigma_;
+    //f_mu and f_sigma, interpolated in sqrt(psi) at least from 1/confidenceMultiplier_ to the largest reachable value
+    std::shared_ptr<const LookupTable> momentFittingTable_;
 
 public:
     TruncatedGaussianScheme(const std::vector<double>& timePoints,
@@ -66,13 +94,23 @@ public:
                             for the first values of psi in the grid when we used a bigger 
                             confidence multiplier*/
                             double confidenceMultiplier = 2, 
-                            //The two following default values are empirically chosen
-                            std::size_t psiGridSize = 100,
+                            /*If positive, number of nodes of a table of f_mu and f_sigma built for the scheme
+                            on its range of psi, instead of the shared table. The initial guess is empirically
+                            chosen */
+                            std::size_t psiGridSize = 0,
                             double initialGuess = 1);
 
     TruncatedGaussianScheme(const TruncatedGaussianScheme& truncatedGaussianScheme);
     ~TruncatedGaussianScheme() = default;
     TruncatedGaussianScheme* clone() const;
+    TruncatedGaussianScheme* cloneWithModel(const HestonModel& hestonModel) const;
+
+    RandomVariableType getRandomVariableType() const;
+    double nextStep(std::size_t currentIndex, double currentValue, double randomVariable,
+                    RandomStream& stream = MathFunctions::generator) const;
+    void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                       const double* randomVariables, double* nextValues,
+                       std::size_t nbPaths, RandomStream* streams = nullptr) const;
 };
 
 class QuadraticExponentialScheme : public HestonVariancePathSimulator
@@ -81,8 +119,6 @@ protected:
     //Switching threshold
     double psiC_;
 
-    double nextStep(std::size_t currentIndex, double currentValue) const;
-
 public:
     QuadraticExponentialScheme(const std::vector<double>& timePoints,
                                 const HestonModel& hestonModel, double psiC = 1.5);
@@ -90,6 +126,47 @@ public:
     QuadraticExponentialScheme(const QuadraticExponentialScheme& quadraticExponentialScheme);
     ~QuadraticExponentialScheme() = default;
     QuadraticExponentialScheme* clone() const;
+    QuadraticExponentialScheme* cloneWithModel(const HestonModel& hestonModel) const;
+
+    RandomVariableType getRandomVariableType() const;
+    double nextStep(std::size_t currentIndex, double currentValue, double randomVariable,
+                    RandomStream& stream = MathFunctions::generator) const;
+    void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                       const double* randomVariables, double* nextValues,
+                       std::size_t nbPaths, RandomStream* streams = nullptr) const;
+};
+
+/*Exact simulation of the variance : V(t+dt) is c/2 times a noncentral chi-square variable with 4 kappa theta/eps²
+degrees of freedom and noncentrality 2 V(t) exp(-kappa dt)/c, c = eps²(1-exp(-kappa dt))/(2 kappa). It is drawn as a
+Poisson mixture of gammas : N is Poisson of mean V(t) exp(-kappa dt)/c, and V(t+dt) = c Gamma(2 kappa theta/eps² + N).
+There is no discretization bias, whatever the steps and the Feller ratio, so that the time points can be the
+observation dates only. The Poisson and gamma draws come from the auxiliary stream of the path for the step */
+class NoncentralChiSquareScheme : public HestonVariancePathSimulator
+{
+private:
+    //Half of the degrees of freedom, i.e. shape of the gamma when N = 0
+    double halfDegreesOfFreedom_;
+    //Pre-computed c and exp(-kappa dt)/c of each step, s.t. N has mean V(t) poissonMeanFactors_ and V(t+dt) = c Gamma
+    std::vector<double> gammaScales_;
+    std::vector<double> poissonMeanFactors_;
+    //Mean of N up to which it is drawn by inversion, the sequential search becoming slower than rejection beyond
+    static constexpr double maxInversionMean = 20.;
+
+    void preComputationsNCX2();
+public:
+    NoncentralChiSquareScheme(const std::vector<double>& timePoints, const HestonModel& hestonModel);
+    NoncentralChiSquareScheme(const NoncentralChiSquareScheme& noncentralChiSquareScheme);
+    ~NoncentralChiSquareScheme() = default;
+    NoncentralChiSquareScheme* clone() const;
+    NoncentralChiSquareScheme* cloneWithModel(const HestonModel& hestonModel) const;
+
+    RandomVariableType getRandomVariableType() const;
+    bool drawsAdditionalRandomVariables() const;
+    double nextStep(std::size_t currentIndex, double currentValue, double randomVariable,
+                    RandomStream& stream = MathFunctions::generator) const;
+    void nextStepBlock(std::size_t currentIndex, const double* currentValues,
+                       const double* randomVariables, double* nextValues,
+                       std::size_t nbPaths, RandomStream* streams = nullptr) const;
 };
 
 #endif 
@@ -0,0 +1,151 @@
+#include "Instrumentation.h"
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+thread_local Instrumentation::Report Instrumentation::currentThreadReport;
+
+namespace
+{
+    std::mutex lastRunReportMutex;
+    Instrumentation::Report lastReport = Instrumentation::Report();
+
+    //Sum of the ticks of all the stages
+    std::uint64_t timedTicks(const Instrumentation::Report& report)
+    {
+        std::uint64_t total = 0;
+        for(std::size_t stageIdx = 0; stageIdx < Instrumentation::nbStages; stageIdx++)
+            total += report.stageTicks[stageIdx];
+        return total;
+    }
+}
+
+std::string Instrumentation::stageName(Stage stage)
+{
+    switch(stage)
+    {
+        case Stage::RandomVariables: return "RandomVariables";
+        case Stage::VarianceStep: return "VarianceStep";
+        case Stage::LogSpotStep: return "LogSpotStep";
+        case Stage::Observations: return "Observations";
+        case Stage::Payoff: return "Payoff";
+    }
+    return "";
+}
+
+std::string Instrumentation::counterName(Counter counter)
+{
+    switch(counter)
+    {
+        case Counter::TruncatedGaussianMomentFitting: return "TruncatedGaussianMomentFitting";
+        case Counter::TruncatedGaussianSkip: return "TruncatedGaussianSkip";
+        case Counter::QuadraticExponentialQuadratic: return "QuadraticExponentialQuadratic";
+        case Counter::QuadraticExponentialExponential: return "QuadraticExponentialExponential";
+    }
+    return "";
+}
+
+void Instrumentation::Report::merge(const Report& report)
+{
+    for(std::size_t stageIdx = 0; stageIdx < nbStages; stageIdx++)
+    {
+        stageCalls[stageIdx] += report.stageCalls[stageIdx];
+        stageItems[stageIdx] += report.stageItems[stageIdx];
+        stageTicks[stageIdx] += report.stageTicks[stageIdx];
+    }
+    for(std::size_t counterIdx = 0; counterIdx < nbCounters; counterIdx++)
+        counters[counterIdx] += report.counters[counterIdx];
+    nbThreads += report.nbThreads;
+}
+
+Instrumentation::Report Instrumentation::Report::since(const Report& start) const
+{
+    Report report = Report();
+    for(std::size_t stageIdx = 0; stageIdx < nbStages; stageIdx++)
+    {
+        report.stageCalls[stageIdx] = stageCalls[stageIdx] - start.stageCalls[stageIdx];
+        report.stageItems[stageIdx] = stageItems[stageIdx] - start.stageItems[stageIdx];
+        report.stageTicks[stageIdx] = stageTicks[stageIdx] - start.stageTicks[stageIdx];
+    }
+    for(std::size_t counterIdx = 0; counterIdx < nbCounters; counterIdx++)
+        report.counters[counterIdx] = counters[counterIdx] - start.counters[counterIdx];
+    report.nbThreads = 1;
+    return report;
+}
+
+void Instrumentation::Report::print(std::ostream& stream) const
+{
+    if(!enabled())
+    {
+        stream << "Instrumentation disabled (configure with -DENABLE_INSTRUMENTATION=ON)" << std::endl;
+        return;
+    }
+    std::ios_base::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    std::uint64_t total = timedTicks(*this);
+    stream << "Run of " << computationTime << " s on " << nbThreads << " thread(s), "
+           << total << " timed ticks" << std::endl;
+    stream << std::left << std::setw(34) << "Stage" << std::right << std::setw(12) << "Calls"
+           << std::setw(16) << "Path steps" << std::setw(18) << "Ticks" << std::setw(14) << "Ticks/step"
+           << std::setw(10) << "Share" << std::endl;
+    for(std::size_t stageIdx = 0; stageIdx < nbStages; stageIdx++)
+    {
+        stream << std::left << std::setw(34) << stageName(Stage(stageIdx)) << std::right
+               << std::setw(12) << stageCalls[stageIdx] << std::setw(16) << stageItems[stageIdx]
+               << std::setw(18) << stageTicks[stageIdx] << std::setw(14) << std::fixed << std::setprecision(2)
+               << (stageItems[stageIdx] > 0 ? double(stageTicks[stageIdx])/stageItems[stageIdx] : 0.)
+               << std::setw(9) << (total > 0 ? 100.*stageTicks[stageIdx]/total : 0.) << "%" << std::endl;
+        stream.flags(flags);
+    }
+    stream << std::left << std::setw(34) << "Counter" << std::right << std::setw(16) << "Path steps" << std::endl;
+    for(std::size_t counterIdx = 0; counterIdx < nbCounters; counterIdx++)
+        stream << std::left << std::setw(34) << counterName(Counter(counterIdx)) << std::right
+               << std::setw(16) << counters[counterIdx] << std::endl;
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void Instrumentation::Report::writeJson(const std::string& fileName) const
+{
+    std::ofstream file;
+    file.open(fileName);
+    file << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n";
+    file << "  \"computation_time\": " << computationTime << ",\n";
+    file << "  \"nb_threads\": " << nbThreads << ",\n";
+    file << "  \"stages\": [\n";
+    for(std::size_t stageIdx = 0; stageIdx < nbStages; stageIdx++)
+    {
+        file << "    {\"name\": \"" << stageName(Stage(stageIdx)) << "\", \"calls\": " << stageCalls[stageIdx]
+             << ", \"path_steps\": " << stageItems[stageIdx] << ", \"ticks\": " << stageTicks[stageIdx] << "}"
+             << (stageIdx+1 < nbStages ? ",\n" : "\n");
+    }
+    file << "  ],\n  \"counters\": {\n";
+    for(std::size_t counterIdx = 0; counterIdx < nbCounters; counterIdx++)
+    {
+        file << "    \"" << counterName(Counter(counterIdx)) << "\": " << counters[counterIdx]
+             << (counterIdx+1 < nbCounters ? ",\n" : "\n");
+    }
+    file << "  }\n}\n";
+    file.close();
+}
+
+bool Instrumentation::enabled()
+{
+#ifdef ENABLE_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+Instrumentation::Report Instrumentation::lastRunReport()
+{
+    std::lock_guard<std::mutex> lock(lastRunReportMutex);
+    return lastReport;
+}
+
+void Instrumentation::setLastRunReport(const Report& report)
+{
+    std::lock_guard<std::mutex> lock(lastRunReportMutex);
+    lastReport = report;
+}
@@ -0,0 +1,130 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/*Counters and timers of the stages of the Monte Carlo pipeline, to find where the time of a slow run goes.
+They are only compiled when ENABLE_INSTRUMENTATION is defined (CMake option of the same name) : otherwise
+the macros below expand to nothing and the kernels are unchanged.
+Each thread accumulates in its own report, without synchronization. The Monte Carlo pricer merges the
+reports of its threads at the end of a run into the last run report */
+namespace Instrumentation
+{
+    //Stages of the simulation of a block of paths, timed separately
+    enum class Stage
+    {
+        //Random variables drawn by the generators
+        RandomVariables,
+        //Step of the variance scheme, including the look-up of the moment-fitting coefficients in TG
+        VarianceStep,
+        //Step of the log-spot scheme
+        LogSpotStep,
+        //Accumulation of the integrated variances and of the squared log-returns between observation dates
+        Observations,
+        //Prices of the paths and their combination into the statistics of the outputs
+        Payoff
+    };
+    const std::size_t nbStages = 5;
+
+    //Branches taken by the variance schemes, counted per path step
+    enum class Counter
+    {
+        TruncatedGaussianMomentFitting,
+        TruncatedGaussianSkip,
+        QuadraticExponentialQuadratic,
+        QuadraticExponentialExponential
+    };
+    const std::size_t nbCounters = 4;
+
+    std::string stageName(Stage stage);
+    std::string counterName(Counter counter);
+
+    /*Plain structure, so that the report of each thread is zero-initialized without a constructor and read
+    by the kernels without going through a function call. Report() is an empty report */
+    struct Report
+    {
+        //Number of times a stage was entered, of path steps (paths for Payoff) it processed, and ticks spent in it
+        std::uint64_t stageCalls[nbStages];
+        std::uint64_t stageItems[nbStages];
+        std::uint64_t stageTicks[nbStages];
+        std::uint64_t counters[nbCounters];
+        //Wall-clock time of the run (in seconds), and number of threads whose reports were merged
+        double computationTime;
+        std::size_t nbThreads;
+
+        void merge(const Report& report);
+        //Report of what was accumulated since start, which is an earlier copy of this report
+        Report since(const Report& start) const;
+        //Table of the stages (calls, path steps, ticks, ticks per step, share of the timed ticks) and counters
+        void print(std::ostream& stream = std::cout) const;
+        void writeJson(const std::string& fileName) const;
+    };
+
+    //True if the library was compiled with ENABLE_INSTRUMENTATION
+    bool enabled();
+
+    /*Time stamp counter on x86 (cycles at the nominal frequency), steady clock in nanoseconds otherwise.
+    The ticks are only compared between stages of the same run */
+    inline std::uint64_t ticks();
+
+    //Report of the calling thread
+    extern thread_local Report currentThreadReport;
+    inline Report& threadReport()
+    {
+        return currentThreadReport;
+    }
+
+    //Report of the last Monte Carlo run, merged over its threads
+    Report lastRunReport();
+    void setLastRunReport(const Report& report);
+
+    //Timer adding the ticks of its scope to a stage of the report of the calling thread
+    class ScopedStageTimer
+    {
+    private:
+        std::size_t stageIdx_;
+        std::uint64_t nbItems_;
+        std::uint64_t start_;
+    public:
+        ScopedStageTimer(Stage stage, std::uint64_t nbItems):
+            stageIdx_(std::size_t(stage)), nbItems_(nbItems), start_(ticks()) {}
+        ~ScopedStageTimer()
+        {
+            Report& report = threadReport();
+            report.stageTicks[stageIdx_] += ticks() - start_;
+            report.stageCalls[stageIdx_]++;
+            report.stageItems[stageIdx_] += nbItems_;
+        }
+    };
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline std::uint64_t Instrumentation::ticks()
+{
+    return __rdtsc();
+}
+#else
+#include <chrono>
+inline std::uint64_t Instrumentation::ticks()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+/*INSTRUMENT_STAGE(stage, nbItems) times the rest of the enclosing scope as the given stage processing
+nbItems path steps (one timer per scope). INSTRUMENT_COUNT(counter, n) adds n to a branch counter */
+#ifdef ENABLE_INSTRUMENTATION
+#define INSTRUMENT_STAGE(stage, nbItems) \
+    Instrumentation::ScopedStageTimer instrumentationStageTimer(Instrumentation::Stage::stage, (nbItems))
+#define INSTRUMENT_COUNT(counter, n) \
+    (Instrumentation::threadReport().counters[std::size_t(Instrumentation::Counter::counter)] += (n))
+#else
+#define INSTRUMENT_STAGE(stage, nbItems) ((void)0)
+#define INSTRUMENT_COUNT(counter, n) ((void)0)
+#endif
+
+#endif
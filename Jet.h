@@ -0,0 +1,118 @@
+#ifndef JET_H
+#define JET_H
+
+#include <cmath>
+#include <complex>
+
+/*Second order jet for forward mode automatic differentiation : value, first and second derivatives
+with respect to a single variable of a quantity of type T (double, std::complex<double> or Dual).
+Arithmetic on jets applies the chain rule, so that evaluating a formula on the jet of the variable
+gives its exact derivatives */
+template<typename T>
+struct Jet
+{
+    typedef T Scalar;
+
+    T value;
+    T firstDerivative;
+    T secondDerivative;
+
+    Jet(T value = T(0.), T firstDerivative = T(0.), T secondDerivative = T(0.)):
+        value(value), firstDerivative(firstDerivative), secondDerivative(secondDerivative) {}
+
+    //Jet of the variable itself at the point x
+    static Jet variable(T x) { return Jet(x, T(1.), T(0.)); }
+};
+
+template<typename T>
+Jet<T> operator-(const Jet<T>& u)
+{
+    return Jet<T>(-u.value, -u.firstDerivative, -u.secondDerivative);
+}
+
+template<typename T>
+Jet<T> operator+(const Jet<T>& u, const Jet<T>& v)
+{
+    return Jet<T>(u.value+v.value, u.firstDerivative+v.firstDerivative, u.secondDerivative+v.secondDerivative);
+}
+
+template<typename T>
+Jet<T> operator-(const Jet<T>& u, const Jet<T>& v)
+{
+    return Jet<T>(u.value-v.value, u.firstDerivative-v.firstDerivative, u.secondDerivative-v.secondDerivative);
+}
+
+template<typename T>
+Jet<T> operator*(const Jet<T>& u, const Jet<T>& v)
+{
+    return Jet<T>(u.value*v.value,
+                  u.firstDerivative*v.value + u.value*v.firstDerivative,
+                  u.secondDerivative*v.value + T(2.)*u.firstDerivative*v.firstDerivative
+                  + u.value*v.secondDerivative);
+}
+
+template<typename T>
+Jet<T> operator/(const Jet<T>& u, const Jet<T>& v)
+{
+    T value = u.value/v.value;
+    T firstDerivative = (u.firstDerivative - value*v.firstDerivative)/v.value;
+    return Jet<T>(value, firstDerivative,
+                  (u.secondDerivative - T(2.)*firstDerivative*v.firstDerivative
+                   - value*v.secondDerivative)/v.value);
+}
+
+/*Operations with constants, which are jets with zero derivatives. The type of the constant is not
+deduced so that real constants can be used with complex jets */
+template<typename T>
+Jet<T> operator+(const Jet<T>& u, const typename Jet<T>::Scalar& c) { return Jet<T>(u.value+c, u.firstDerivative, u.secondDerivative); }
+template<typename T>
+Jet<T> operator+(const typename Jet<T>::Scalar& c, const Jet<T>& u) { return u+c; }
+template<typename T>
+Jet<T> operator-(const Jet<T>& u, const typename Jet<T>::Scalar& c) { return Jet<T>(u.value-c, u.firstDerivative, u.secondDerivative); }
+template<typename T>
+Jet<T> operator-(const typename Jet<T>::Scalar& c, const Jet<T>& u) { return Jet<T>(c-u.value, -u.firstDerivative, -u.secondDerivative); }
+template<typename T>
+Jet<T> operator*(const Jet<T>& u, const typename Jet<T>::Scalar& c) { return Jet<T>(u.value*c, u.firstDerivative*c, u.secondDerivative*c); }
+template<typename T>
+Jet<T> operator*(const typename Jet<T>::Scalar& c, const Jet<T>& u) { return u*c; }
+template<typename T>
+Jet<T> operator/(const Jet<T>& u, const typename Jet<T>::Scalar& c) { return Jet<T>(u.value/c, u.firstDerivative/c, u.secondDerivative/c); }
+template<typename T>
+Jet<T> operator/(const typename Jet<T>::Scalar& c, const Jet<T>& u) { return Jet<T>(c)/u; }
+
+/*Composition with a function f, given f(u), f'(u) and f''(u) at the value u of the jet :
+(f o u)' = f'(u) u' and (f o u)'' = f''(u) u'^2 + f'(u) u'' */
+template<typename T>
+Jet<T> compose(const Jet<T>& u, T f, T fPrime, T fSecond)
+{
+    return Jet<T>(f, fPrime*u.firstDerivative,
+                  fSecond*u.firstDerivative*u.firstDerivative + fPrime*u.secondDerivative);
+}
+
+//The functions of the values are called unqualified so that those of T are found by argument lookup
+template<typename T>
+Jet<T> exp(const Jet<T>& u)
+{
+    using std::exp;
+    T e = exp(u.value);
+    return compose(u, e, e, e);
+}
+
+template<typename T>
+Jet<T> log(const Jet<T>& u)
+{
+    using std::log;
+    T inverse = T(1.)/u.value;
+    return compose(u, log(u.value), inverse, -inverse*inverse);
+}
+
+template<typename T>
+Jet<T> sqrt(const Jet<T>& u)
+{
+    using std::sqrt;
+    T s = sqrt(u.value);
+    T fPrime = T(0.5)/s;
+    return compose(u, s, fPrime, -fPrime/(T(2.)*u.value));
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "LookupTable.h"
+#include <cstdint>
+#include <utility>
+
+namespace
+{
+    //Size of a cache line, in doubles
+    const std::size_t cacheLineSize = 8;
+}
+
+LookupTable::LookupTable(std::function<void(double, double*)> f, std::size_t nbFunctions, double min, double max,
+                         std::size_t nbNodes, Interpolation interpolation):
+        min_(min), max_(max),
+        nbFunctions_(nbFunctions),
+        nbIntervals_(nbNodes-1),
+        interpolation_(interpolation),
+        nbCoefficients_(interpolation == Interpolation::Cubic ? 4 : 2)
+{
+    intervalStride_ = nbFunctions_*nbCoefficients_;
+    //The intervals are padded to whole cache lines when they are not a divisor of a cache line
+    if(intervalStride_ < cacheLineSize)
+    {
+        while(cacheLineSize%intervalStride_ != 0)
+            intervalStride_++;
+    }
+    else
+        intervalStride_ = (intervalStride_+cacheLineSize-1)/cacheLineSize*cacheLineSize;
+    double step = (max_-min_)/nbIntervals_;
+    inverseStep_ = 1./step;
+    allocate();
+
+    /*The polynomials are written in the local coordinate t = (x-x_i)/step of [0,1]. The cubic one
+    interpolates the values at t = 0, 1/3, 2/3 and 1, the nodes being shared by neighbouring intervals */
+    std::size_t nbSamplesPerInterval = interpolation_ == Interpolation::Cubic ? 3 : 1;
+    std::vector<double> samples((nbIntervals_*nbSamplesPerInterval+1)*nbFunctions_);
+    for(std::size_t sampleIdx = 0; sampleIdx <= nbIntervals_*nbSamplesPerInterval; sampleIdx++)
+    {
+        double x = sampleIdx == nbIntervals_*nbSamplesPerInterval
+                   ? max_ : min_ + step*double(sampleIdx)/nbSamplesPerInterval;
+        f(x, &samples[sampleIdx*nbFunctions_]);
+    }
+
+    for(std::size_t intervalIdx = 0; intervalIdx < nbIntervals_; intervalIdx++)
+    {
+        double* coefficients = &storage_[alignmentOffset_ + intervalIdx*intervalStride_];
+        for(std::size_t functionIdx = 0; functionIdx < nbFunctions_; functionIdx++)
+        {
+            const double* value = &samples[intervalIdx*nbSamplesPerInterval*nbFunctions_ + functionIdx];
+            if(interpolation_ == Interpolation::Cubic)
+            {
+                //Newton's divided differences on the points 0, 1/3, 2/3 and 1, expanded in powers of t
+                double y0 = value[0], y1 = value[nbFunctions_], y2 = value[2*nbFunctions_],
+                       y3 = value[3*nbFunctions_];
+                coefficients[4*functionIdx] = y0;
+                coefficients[4*functionIdx+1] = (-11*y0 + 18*y1 - 9*y2 + 2*y3)/2;
+                coefficients[4*functionIdx+2] = 9*(2*y0 - 5*y1 + 4*y2 - y3)/2;
+                coefficients[4*functionIdx+3] = 9*(-y0 + 3*y1 - 3*y2 + y3)/2;
+            }
+            else
+            {
+                coefficients[2*functionIdx] = value[0];
+                coefficients[2*functionIdx+1] = value[nbFunctions_] - value[0];
+            }
+        }
+    }
+}
+
+LookupTable::LookupTable(const LookupTable& lookupTable):
+        min_(lookupTable.min_), max_(lookupTable.max_),
+        nbFunctions_(lookupTable.nbFunctions_),
+        nbIntervals_(lookupTable.nbIntervals_),
+        interpolation_(lookupTable.interpolation_),
+        nbCoefficients_(lookupTable.nbCoefficients_),
+        intervalStride_(lookupTable.intervalStride_),
+        inverseStep_(lookupTable.inverseStep_)
+{
+    //The copy is realigned, its storage having another address
+    allocate();
+    std::copy(lookupTable.storage_.begin() + lookupTable.alignmentOffset_,
+              lookupTable.storage_.begin() + lookupTable.alignmentOffset_ + nbIntervals_*intervalStride_,
+              storage_.begin() + alignmentOffset_);
+}
+
+LookupTable& LookupTable::operator=(const LookupTable& lookupTable)
+{
+    //Swapping the vectors keeps their buffers, and hence the alignment of the copy
+    LookupTable copy(lookupTable);
+    std::swap(min_, copy.min_);
+    std::swap(max_, copy.max_);
+    std::swap(nbFunctions_, copy.nbFunctions_);
+    std::swap(nbIntervals_, copy.nbIntervals_);
+    std::swap(interpolation_, copy.interpolation_);
+    std::swap(nbCoefficients_, copy.nbCoefficients_);
+    std::swap(intervalStride_, copy.intervalStride_);
+    std::swap(inverseStep_, copy.inverseStep_);
+    storage_.swap(copy.storage_);
+    std::swap(alignmentOffset_, copy.alignmentOffset_);
+    return *this;
+}
+
+void LookupTable::allocate()
+{
+    storage_.assign(nbIntervals_*intervalStride_ + cacheLineSize, 0.);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage_.data());
+    std::size_t misalignment = (address/sizeof(double))%cacheLineSize;
+    alignmentOffset_ = misalignment == 0 ? 0 : cacheLineSize - misalignment;
+}
+
+double LookupTable::getMin() const
+{
+    return min_;
+}
+
+double LookupTable::getMax() const
+{
+    return max_;
+}
+
+std::size_t LookupTable::getNbNodes() const
+{
+    return nbIntervals_+1;
+}
+
+std::size_t LookupTable::getNbFunctions() const
+{
+    return nbFunctions_;
+}
+
+Interpolation LookupTable::getInterpolation() const
+{
+    return interpolation_;
+}
@@ -0,0 +1,162 @@
+#ifndef LOOKUPTABLE_H
+#define LOOKUPTABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+//Interpolation of a lookup table between two nodes
+enum class Interpolation
+{
+    Linear,
+    /*Cubic polynomial through the two nodes and two equally spaced points inside the interval. The error
+    decreases like the fourth power of the step instead of the square : a table with a few times fewer
+    nodes has the same accuracy and fits in L1 */
+    Cubic
+};
+
+/*Table of one or several functions of one variable, tabulated on a uniform grid of [min,max] and
+interpolated piecewise. The interval of x is computed directly from x, in O(1).
+The coefficients of the polynomials of all the functions on an interval are stored contiguously,
+the intervals being aligned on cache lines : a look-up of two cubic functions loads a single cache line.
+x is clamped to [min,max] */
+class LookupTable
+{
+private:
+    double min_;
+    double max_;
+    std::size_t nbFunctions_;
+    std::size_t nbIntervals_;
+    Interpolation interpolation_;
+    //Number of coefficients of a polynomial, and stride between the coefficients of two intervals
+    std::size_t nbCoefficients_;
+    std::size_t intervalStride_;
+    double inverseStep_;
+
+    //Coefficients, stored in storage_ from its first element aligned on a cache line
+    std::vector<double> storage_;
+    std::size_t alignmentOffset_;
+
+    //Method allocating storage_ and setting alignmentOffset_
+    void allocate();
+    //Method returning the coefficients of the interval of x, and setting t to the local coordinate of x in it
+    inline const double* interval(double x, double& t) const;
+#if defined(__AVX2__) && defined(__FMA__)
+    /*Method gathering the 4 doubles at coefficients + offsets. The masked gather with a zero source is used
+    because _mm256_i32gather_pd reads its undefined source register, which GCC reports as uninitialized */
+    static inline __m256d gather(const double* coefficients, __m128i offsets);
+#endif
+public:
+    /*The functions are computed by f(x, values), which fills values[0..nbFunctions-1]. nbNodes is the number
+    of nodes of the grid, min and max included (at least 2), and min < max */
+    LookupTable(std::function<void(double, double*)> f, std::size_t nbFunctions, double min, double max,
+                std::size_t nbNodes, Interpolation interpolation = Interpolation::Cubic);
+
+    LookupTable(const LookupTable& lookupTable);
+    LookupTable& operator=(const LookupTable& lookupTable);
+
+    double getMin() const;
+    double getMax() const;
+    std::size_t getNbNodes() const;
+    std::size_t getNbFunctions() const;
+    Interpolation getInterpolation() const;
+
+    //Method filling values[0..nbFunctions-1] with the interpolated functions at x
+    inline void evaluate(double x, double* values) const;
+    /*Same method when the number of functions is known at compile time (NbFunctions must be
+    getNbFunctions()), so that the loop over the functions is unrolled in the hot loops */
+    template<std::size_t NbFunctions>
+    inline void evaluate(double x, double* values) const;
+#if defined(__AVX2__) && defined(__FMA__)
+    /*Same method at 4 points at once, values[k] receiving the function k at the 4 points. The coefficients
+    are gathered from the intervals of the 4 points, and the results are those of the scalar method */
+    template<std::size_t NbFunctions>
+    inline void evaluate(__m256d x, __m256d* values) const;
+#endif
+};
+
+inline const double* LookupTable::interval(double x, double& t) const
+{
+    //Position of x in units of the step. The last interval includes max, where t = 1
+    double position = (std::min(std::max(x, min_), max_) - min_)*inverseStep_;
+    std::ptrdiff_t intervalIdx = std::ptrdiff_t(std::min(position, double(nbIntervals_-1)));
+    t = position - double(intervalIdx);
+    return &storage_[alignmentOffset_ + intervalIdx*intervalStride_];
+}
+
+inline void LookupTable::evaluate(double x, double* values) const
+{
+    double t;
+    const double* coefficients = interval(x, t);
+    if(interpolation_ == Interpolation::Cubic)
+    {
+        for(std::size_t functionIdx = 0; functionIdx < nbFunctions_; functionIdx++, coefficients += 4)
+            values[functionIdx] = coefficients[0] + t*(coefficients[1] + t*(coefficients[2] + t*coefficients[3]));
+    }
+    else
+    {
+        for(std::size_t functionIdx = 0; functionIdx < nbFunctions_; functionIdx++, coefficients += 2)
+            values[functionIdx] = coefficients[0] + t*coefficients[1];
+    }
+}
+
+template<std::size_t NbFunctions>
+inline void LookupTable::evaluate(double x, double* values) const
+{
+    double t;
+    const double* coefficients = interval(x, t);
+    if(interpolation_ == Interpolation::Cubic)
+    {
+        for(std::size_t functionIdx = 0; functionIdx < NbFunctions; functionIdx++, coefficients += 4)
+            values[functionIdx] = coefficients[0] + t*(coefficients[1] + t*(coefficients[2] + t*coefficients[3]));
+    }
+    else
+    {
+        for(std::size_t functionIdx = 0; functionIdx < NbFunctions; functionIdx++, coefficients += 2)
+            values[functionIdx] = coefficients[0] + t*coefficients[1];
+    }
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+inline __m256d LookupTable::gather(const double* coefficients, __m128i offsets)
+{
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), coefficients, offsets,
+                                    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+template<std::size_t NbFunctions>
+inline void LookupTable::evaluate(__m256d x, __m256d* values) const
+{
+    //Same position and interval as the scalar method
+    __m256d position = _mm256_mul_pd(_mm256_sub_pd(_mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(min_)),
+                                                                 _mm256_set1_pd(max_)),
+                                                   _mm256_set1_pd(min_)),
+                                     _mm256_set1_pd(inverseStep_));
+    __m256d intervalPosition = _mm256_floor_pd(_mm256_min_pd(position, _mm256_set1_pd(double(nbIntervals_-1))));
+    __m256d t = _mm256_sub_pd(position, intervalPosition);
+    __m128i offsets = _mm_mullo_epi32(_mm256_cvttpd_epi32(intervalPosition), _mm_set1_epi32(int(intervalStride_)));
+    const double* coefficients = &storage_[alignmentOffset_];
+    if(interpolation_ == Interpolation::Cubic)
+    {
+        for(std::size_t functionIdx = 0; functionIdx < NbFunctions; functionIdx++, coefficients += 4)
+        {
+            __m256d value = gather(coefficients + 3, offsets);
+            value = _mm256_fmadd_pd(value, t, gather(coefficients + 2, offsets));
+            value = _mm256_fmadd_pd(value, t, gather(coefficients + 1, offsets));
+            values[functionIdx] = _mm256_fmadd_pd(value, t, gather(coefficients, offsets));
+        }
+    }
+    else
+    {
+        for(std::size_t functionIdx = 0; functionIdx < NbFunctions; functionIdx++, coefficients += 2)
+            values[functionIdx] = _mm256_fmadd_pd(gather(coefficients + 1, offsets), t,
+                                                  gather(coefficients, offsets));
+    }
+}
+#endif
+
+#endif
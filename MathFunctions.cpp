@@ -1,6 +1,63 @@
 #include "MathFunctions.h"
 #include <cstdlib>
-#include <random>
+#include <algorithm>
+#include <atomic>
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    //Abscissas of the layers of the Ziggurat for the standard Gaussian density (unnormalized)
+    struct ZigguratTables
+    {
+        static const int nbLayers = 256;
+        //Start of the tail and common area of the layers
+        static constexpr double tailStart = 3.6541528853610088;
+        static constexpr double layerArea = 0.00492867323399;
+
+        //x[i] is the right end of the layer i, x[nbLayers] = 0
+        double x[nbLayers+1];
+        //ratio[i] = x[i+1]/x[i] : below it, a point of the layer i is under the density
+        double ratio[nbLayers];
+
+        ZigguratTables()
+        {
+            double f = std::exp(-0.5*tailStart*tailStart);
+            x[0] = layerArea/f;
+            x[1] = tailStart;
+            for(int i = 2; i < nbLayers; i++)
+            {
+                x[i] = std::sqrt(-2*std::log(layerArea/x[i-1]+f));
+                f = std::exp(-0.5*x[i]*x[i]);
+            }
+            x[nbLayers] = 0.;
+            for(int i = 0; i < nbLayers; i++)
+                ratio[i] = x[i+1]/x[i];
+        }
+    };
+
+    const ZigguratTables zigguratTables;
+
+    /*log(k!), computed without std::lgamma, which writes the global signgam and races between the threads of the
+    Monte Carlo pricer. Exact values up to 9, Stirling series above, accurate to 1e-10 */
+    double logFactorial(double k)
+    {
+        static const double smallLogFactorials[10] = {
+            0., 0., 0.6931471805599453, 1.791759469228055, 3.1780538303479458, 4.787491742782046,
+            6.579251212010101, 8.525161361065415, 10.60460290274525, 12.801827480081469};
+        if(k < 10.)
+            return smallLogFactorials[std::size_t(k)];
+        double inverseK = 1./k;
+        return 0.9189385332046728 + (k + 0.5)*std::log(k) - k
+               + inverseK*(1./12. - inverseK*inverseK*(1./360. - inverseK*inverseK/1260.));
+    }
+
+    //The default streams of the threads are placed after those of the paths, and before those of the quasi-random generator
+    const std::uint64_t defaultStreamsOffset = std::uint64_t(1) << 62;
+    //Number of threads which have drawn from their default stream
+    std::atomic<std::uint64_t> nbDefaultStreams(0);
+}
 
 namespace MathFunctions
 {
@@ -15,64 +72,353 @@ namespace MathFunctions
     }
 
 
+    //Coefficients of Moro's formula : rational approximation in the center, polynomial in log(-log) in the tails
+    static const double moroA[4] = {2.50662823884, -18.61500062529, 41.39119773534, -25.44106049637};
+    static const double moroB[4] = {-8.47351093090, 23.08336743743, -21.06224101826, 3.13082909833};
+    static const double moroC[9] = {0.3374754822726147, 0.9761690190917186, 0.1607979714918209,
+                                    0.0276438810333863, 0.0038405729373609, 0.0003951896511919,
+                                    0.0000321767881768, 0.0000002888167364, 0.0000003960315187};
+
     double normalCDFInverse(double x)
     {
-        static const double a0 = 2.50662823884;
-        double a1 = -18.61500062529;
-        double a2 = 41.39119773534;
-        double a3 =-25.44106049637;
-        double b0  = -8.47351093090;
-        double b1 = 23.08336743743;
-        double b2 =-21.06224101826;
-        double b3 =  3.13082909833;
-        double c0 = 0.3374754822726147;
-        double c1 = 0.9761690190917186;
-        double c2 = 0.1607979714918209;
-        double c3 = 0.0276438810333863;
-        double c4 = 0.0038405729373609;
-        double c5 = 0.0003951896511919;
-        double c6 =  0.0000321767881768;
-        double c7 = 0.0000002888167364;
-        double c8 = 0.0000003960315187;
-
         double result;
         double temp = x - 0.5;
 
-        if (abs(temp)<0.42){
+        if (std::abs(temp)<0.42){
             result = temp*temp;
             result = temp*
-                    (((a3*result+a2)*result+a1)*result+a0) /
-                    ((((b3*result+b2)*result+b1)*result+b0)*result+1.0);
+                    (((moroA[3]*result+moroA[2])*result+moroA[1])*result+moroA[0]) /
+                    ((((moroB[3]*result+moroB[2])*result+moroB[1])*result+moroB[0])*result+1.0);
         } else{
             if (x<0.5)
                 result = x;
             else
                 result=1.0-x;
             result = std::log(-std::log(result));
-            result = c0+result*(c1+result*(c2+result*(c3+result*
-                                                        (c4+result*(c5+result*(c6+result*
-                                                                                (c7+result*c8)))))));
+            result = moroC[0]+result*(moroC[1]+result*(moroC[2]+result*(moroC[3]+result*
+                                                        (moroC[4]+result*(moroC[5]+result*(moroC[6]+result*
+                                                                                (moroC[7]+result*moroC[8])))))));
             if (x<0.5)
                 result=-result;
         }
         return result;
     }
 
+#if defined(__AVX2__) && defined(__FMA__)
+    //Natural logarithm of 4 positive normal doubles : log(m*2^e) = e*log(2) + 2*atanh((m-1)/(m+1))
+    static __m256d logAVX2(__m256d x)
+    {
+        const __m256i mantissaMask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+        const __m256i one = _mm256_set1_epi64x(0x3FF0000000000000LL);
+        //Magic number used to convert the (small) exponents from integers to doubles
+        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+        const __m256d ones = _mm256_set1_pd(1.0);
+
+        __m256i bits = _mm256_castpd_si256(x);
+        //m is in [1,2) and e is the unbiased exponent
+        __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), one));
+        __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic)),
+                                  _mm256_set1_pd(4503599627370496.0 + 1023.0));
+        //m is brought back to [sqrt(2)/2, sqrt(2)) so that |(m-1)/(m+1)| <= 0.172
+        __m256d isLarge = _mm256_cmp_pd(m, _mm256_set1_pd(M_SQRT2), _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), isLarge);
+        e = _mm256_add_pd(e, _mm256_and_pd(isLarge, ones));
+
+        __m256d f = _mm256_div_pd(_mm256_sub_pd(m, ones), _mm256_add_pd(m, ones));
+        __m256d f2 = _mm256_mul_pd(f, f);
+        //Series of atanh(f)/f = sum f^(2k)/(2k+1), truncated when the terms are below the double precision
+        __m256d series = _mm256_set1_pd(1.0/21);
+        for(int k = 9; k >= 0; k--)
+            series = _mm256_fmadd_pd(series, f2, _mm256_set1_pd(1.0/(2*k+1)));
+        __m256d logM = _mm256_mul_pd(_mm256_add_pd(f, f), series);
+
+        //log(2) is split in two parts so that e*log(2) is exact up to the last bit
+        __m256d result = _mm256_fmadd_pd(e, _mm256_set1_pd(1.9082149292705877e-10), logM);
+        return _mm256_fmadd_pd(e, _mm256_set1_pd(0.69314718036912382), result);
+    }
+#endif
+
+    void normalCDFInverse(const double* x, double* result, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+        const __m256d half = _mm256_set1_pd(0.5);
+        const __m256d ones = _mm256_set1_pd(1.0);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d u = _mm256_loadu_pd(x + i);
+            __m256d temp = _mm256_sub_pd(u, half);
+            __m256d isCentral = _mm256_cmp_pd(_mm256_andnot_pd(signMask, temp),
+                                              _mm256_set1_pd(0.42), _CMP_LT_OQ);
+
+            //Central region, evaluated on every lane
+            __m256d r = _mm256_mul_pd(temp, temp);
+            __m256d numerator = _mm256_set1_pd(moroA[3]);
+            for(int k = 2; k >= 0; k--)
+                numerator = _mm256_fmadd_pd(numerator, r, _mm256_set1_pd(moroA[k]));
+            __m256d denominator = _mm256_set1_pd(moroB[3]);
+            for(int k = 2; k >= 0; k--)
+                denominator = _mm256_fmadd_pd(denominator, r, _mm256_set1_pd(moroB[k]));
+            denominator = _mm256_fmadd_pd(denominator, r, ones);
+            __m256d z = _mm256_div_pd(_mm256_mul_pd(temp, numerator), denominator);
+
+            //Tails, only evaluated if one of the lanes needs it
+            if(_mm256_movemask_pd(isCentral) != 0xF)
+            {
+                __m256d y = _mm256_min_pd(u, _mm256_sub_pd(ones, u));
+                __m256d s = logAVX2(_mm256_xor_pd(logAVX2(y), signMask));
+                __m256d tail = _mm256_set1_pd(moroC[8]);
+                for(int k = 7; k >= 0; k--)
+                    tail = _mm256_fmadd_pd(tail, s, _mm256_set1_pd(moroC[k]));
+                //The tail has the sign of u-0.5
+                tail = _mm256_or_pd(tail, _mm256_and_pd(temp, signMask));
+                z = _mm256_blendv_pd(tail, z, isCentral);
+            }
+            _mm256_storeu_pd(result + i, z);
+        }
+#endif
+        //Scalar fallback, also used for the last elements
+        for(; i < n; i++)
+            result[i] = normalCDFInverse(x[i]);
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+    //Exponential of 4 doubles in [-708,709] : exp(k*log(2)+r) = 2^k*exp(r) with |r| <= log(2)/2
+    static __m256d expAVX2(__m256d x)
+    {
+        //Magic number used to convert the (small) integers k from doubles to the exponent bits
+        const __m256d magic = _mm256_set1_pd(4503599627370496.0 + 1023.0);
+        __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(M_LOG2E)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        //log(2) is split in two parts so that r is exact up to the last bit
+        __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(0.69314718036912382), x);
+        r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.9082149292705877e-10), r);
+
+        //Taylor series of exp(r), truncated when the terms are below the double precision
+        double coefficient = 1.;
+        for(int i = 2; i <= 13; i++)
+            coefficient /= i;
+        __m256d series = _mm256_set1_pd(coefficient);
+        for(int i = 13; i >= 1; i--)
+        {
+            coefficient *= i;
+            series = _mm256_fmadd_pd(series, r, _mm256_set1_pd(coefficient));
+        }
+
+        __m256i twoPowerK = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(k, magic)), 52);
+        return _mm256_mul_pd(series, _mm256_castsi256_pd(twoPowerK));
+    }
+#endif
+
+    void exponential(const double* x, double* result, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+        const __m256d lowerBound = _mm256_set1_pd(-708.);
+        const __m256d upperBound = _mm256_set1_pd(709.);
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256d y = _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(x + i), lowerBound), upperBound);
+            _mm256_storeu_pd(result + i, expAVX2(y));
+        }
+#endif
+        //Scalar fallback, also used for the last elements
+        for(; i < n; i++)
+            result[i] = std::exp(std::min(std::max(x[i], -708.), 709.));
+    }
+
+    void logarithm(const double* x, double* result, std::size_t n)
+    {
+        std::size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+        for(; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(result + i, logAVX2(_mm256_loadu_pd(x + i)));
+#endif
+        //Scalar fallback, also used for the last elements
+        for(; i < n; i++)
+            result[i] = std::log(x[i]);
+    }
+
     //We set the value of the seed to a given value
     unsigned seed = 10;
-    std::default_random_engine generator(seed);
+    thread_local RandomStream generator(seed, defaultStreamsOffset + nbDefaultStreams++);
 
-    double simulateUniformRandomVariable()
+    double simulateUniformRandomVariable(RandomStream& stream)
     {
-        std::uniform_real_distribution<double> distribution(0.0,1.0);
-        return distribution(generator);
+        return stream.nextUniform();
     }
-    double simulateGaussianRandomVariable()
+    double simulateGaussianRandomVariable(RandomStream& stream)
     {
-        double u = simulateUniformRandomVariable(), v = simulateUniformRandomVariable();
+        double u = stream.nextUniform(), v = stream.nextUniform();
         return std::sqrt(-2*std::log(u))*std::sin(2*M_PI*v);
     }
 
+    double simulateZigguratGaussianRandomVariable(RandomStream& stream)
+    {
+        const ZigguratTables& tables = zigguratTables;
+        while(true)
+        {
+            //The 8 lower bits select the layer, the 53 upper bits give a uniform on (-1,1)
+            std::uint64_t bits = stream.nextBits();
+            int i = int(bits & 0xFF);
+            double u = 2*(double(bits >> 11) + 0.5)*(1.0/9007199254740992.0) - 1;
+
+            //Fast path : the point is inside the rectangle under the density
+            if(std::abs(u) < tables.ratio[i])
+                return u*tables.x[i];
+
+            if(i == 0)
+            {
+                //Tail of the density beyond tailStart (Marsaglia's method)
+                double x, y;
+                do
+                {
+                    x = -std::log(stream.nextUniform())/ZigguratTables::tailStart;
+                    y = -std::log(stream.nextUniform());
+                } while(2*y < x*x);
+                return u > 0 ? ZigguratTables::tailStart + x : -ZigguratTables::tailStart - x;
+            }
+
+            //Wedge between the rectangle and the density
+            double x = u*tables.x[i];
+            double f0 = std::exp(-0.5*(tables.x[i]*tables.x[i]-x*x));
+            double f1 = std::exp(-0.5*(tables.x[i+1]*tables.x[i+1]-x*x));
+            if(f1+stream.nextUniform()*(f0-f1) < 1.0)
+                return x;
+        }
+    }
+
+    void simulateUniformRandomVariables(double* randomVariables, std::size_t n, RandomStream& stream)
+    {
+        for(std::size_t i = 0; i < n; i++)
+            randomVariables[i] = stream.nextUniform();
+    }
+
+    void simulateGaussianRandomVariables(double* randomVariables, std::size_t n, RandomStream& stream)
+    {
+        for(std::size_t i = 0; i < n; i++)
+            randomVariables[i] = simulateZigguratGaussianRandomVariable(stream);
+    }
+
+    double simulateGammaRandomVariable(double shape, RandomStream& stream)
+    {
+        if(shape < 1.)
+        {
+            double u = stream.nextUniform();
+            return simulateGammaRandomVariable(shape+1., stream)*std::pow(u, 1./shape);
+        }
+        double d = shape - 1./3., c = 1./std::sqrt(9.*d);
+        while(true)
+        {
+            double x, v;
+            do
+            {
+                x = simulateZigguratGaussianRandomVariable(stream);
+                v = 1. + c*x;
+            } while(v <= 0.);
+            v = v*v*v;
+            double u = stream.nextUniform();
+            //Squeeze, accepting most draws without logarithm
+            if(u < 1. - 0.0331*x*x*x*x)
+                return d*v;
+            if(std::log(u) < 0.5*x*x + d*(1. - v + std::log(v)))
+                return d*v;
+        }
+    }
+
+    std::size_t simulatePoissonRandomVariable(double mean, RandomStream& stream)
+    {
+        if(mean <= 0.)
+            return 0;
+        if(mean < 10.)
+            return poissonCDFInverse(mean, stream.nextUniform());
+        //Transformed rejection with squeeze (Hormann 1993)
+        double logMean = std::log(mean);
+        double b = 0.931 + 2.53*std::sqrt(mean);
+        double a = -0.059 + 0.02483*b;
+        double inverseAlpha = 1.1239 + 1.1328/(b-3.4);
+        double vr = 0.9277 - 3.6224/(b-2.);
+        while(true)
+        {
+            double u = stream.nextUniform() - 0.5;
+            double v = stream.nextUniform();
+            double us = 0.5 - std::abs(u);
+            double k = std::floor((2.*a/us + b)*u + mean + 0.43);
+            if(us >= 0.07 && v <= vr)
+                return std::size_t(k);
+            if(k < 0. || (us < 0.013 && v > us))
+                continue;
+            if(std::log(v) + std::log(inverseAlpha) - std::log(a/(us*us) + b)
+                    <= -mean + k*logMean - logFactorial(k))
+                return std::size_t(k);
+        }
+    }
+
+    std::size_t poissonCDFInverse(double mean, double x, double* conditionalUniform)
+    {
+        //Sequential search of the cdf, stopped if the probabilities underflow
+        double probability = std::exp(-mean);
+        double cdf = probability;
+        std::size_t k = 0;
+        while(x > cdf && probability > 0.)
+        {
+            k++;
+            probability *= mean/k;
+            cdf += probability;
+        }
+        if(conditionalUniform)
+            *conditionalUniform = probability > 0. ? std::min(std::max(1. - (cdf-x)/probability, 0.), 1.) : x;
+        return k;
+    }
+
+    std::size_t simulateBesselRandomVariable(double nu, double z, RandomStream& stream)
+    {
+        if(z <= 0.)
+            return 0;
+        /*The probability of n+1 is that of n times q/((n+1)(n+1+nu)), so that the mode is the largest n
+        such that n(n+nu) <= q. The probabilities are computed relatively to that of the mode, and are
+        neglected below 1e-17 times it */
+        double q = 0.25*z*z;
+        const double negligible = 1e-17;
+        std::size_t mode = std::size_t(std::max(0., std::floor(0.5*(std::sqrt(z*z + nu*nu) - nu))));
+        double total = 1., weight = 1.;
+        for(std::size_t n = mode; weight > negligible; n++)
+        {
+            weight *= q/((n+1.)*(n+1.+nu));
+            total += weight;
+        }
+        weight = 1.;
+        for(std::size_t n = mode; n > 0 && weight > negligible; n--)
+        {
+            weight *= n*(n+nu)/q;
+            total += weight;
+        }
+
+        //Inversion, going through the mode, the values above it and then those below it
+        double u = stream.nextUniform()*total - 1.;
+        if(u < 0.)
+            return mode;
+        weight = 1.;
+        for(std::size_t n = mode; weight > negligible; n++)
+        {
+            weight *= q/((n+1.)*(n+1.+nu));
+            u -= weight;
+            if(u < 0.)
+                return n+1;
+        }
+        weight = 1.;
+        for(std::size_t n = mode; n > 0 && weight > negligible; n--)
+        {
+            weight *= n*(n+nu)/q;
+            u -= weight;
+            if(u < 0.)
+                return n-1;
+        }
+        //Rounding errors in the total
+        return mode;
+    }
+
     double newtonMethod(double initialGuess, std::function<double(double)> f, std::function<double(double)> fPrime, double precision)
     {
         double x = initialGuess;
@@ -6,8 +6,8 @@
 #include <complex>
 #include <functional>
 #include <vector>
-#include <random>
 #include <iostream>
+#include "RandomStream.h"
 
 
 namespace MathFunctions
@@ -19,14 +19,59 @@ namespace MathFunctions
     //Inverse of the normal cdf (Moho's formula)
     double normalCDFInverse(double x);
 
-    //Those are used to set the seed of the random number generator
+    /*Inverse of the normal cdf applied to the n first elements of x (in (0,1)).
+    When the code is compiled for AVX2, 4 values are computed at once, the tails using a vectorized
+    logarithm. Otherwise it falls back on the scalar version */
+    void normalCDFInverse(const double* x, double* result, std::size_t n);
+
+    /*Exponential of the n first elements of x, which are clamped to [-708,709] so that the result is a
+    normal double. When the code is compiled for AVX2, 4 values are computed at once */
+    void exponential(const double* x, double* result, std::size_t n);
+
+    /*Natural logarithm of the n first elements of x, which must be positive normal doubles. When the code is
+    compiled for AVX2, 4 values are computed at once */
+    void logarithm(const double* x, double* result, std::size_t n);
+
+    /*Seed of the random number generators. The default stream used by the functions below is thread local :
+    the n-th thread to draw from it gets the n-th default stream of this seed, so that two threads never draw the
+    same numbers. Which thread gets which stream depends on the order in which they start drawing, reproducible
+    draws need an explicit stream*/
     extern unsigned seed;
-    extern std::default_random_engine generator;
+    extern thread_local RandomStream generator;
 
-    double simulateUniformRandomVariable();
+    double simulateUniformRandomVariable(RandomStream& stream = generator);
     
     //Simulate a standard Gaussian variable using Box-Muller method
-    double simulateGaussianRandomVariable();
+    double simulateGaussianRandomVariable(RandomStream& stream = generator);
+
+    /*Simulate a standard Gaussian variable using the Ziggurat method (Marsaglia and Tsang, 256 layers).
+    Most draws only cost one 64 bits word, a multiplication and a comparison */
+    double simulateZigguratGaussianRandomVariable(RandomStream& stream = generator);
+
+    //Fill the n first elements of randomVariables with independent draws
+    void simulateUniformRandomVariables(double* randomVariables, std::size_t n,
+                                        RandomStream& stream = generator);
+    //The Gaussian variables are drawn with the Ziggurat method
+    void simulateGaussianRandomVariables(double* randomVariables, std::size_t n,
+                                         RandomStream& stream = generator);
+
+    /*Simulate a Gamma variable of the given shape and of scale 1 (Marsaglia and Tsang's method). A shape below 1
+    is boosted : Gamma(shape) = Gamma(shape+1)*U^(1/shape) */
+    double simulateGammaRandomVariable(double shape, RandomStream& stream = generator);
+
+    /*Simulate a Poisson variable of the given mean, by inversion for small means and by transformed rejection
+    (Hormann's PTRS) otherwise, so that the cost doesn't grow with the mean */
+    std::size_t simulatePoissonRandomVariable(double mean, RandomStream& stream = generator);
+
+    /*Inverse of the cdf of the Poisson distribution of the given mean, by sequential search : the cost grows with
+    the mean. If conditionalUniform is given, it receives the position of x inside the jump of the cdf at the
+    result, which is a uniform variable independent of the result */
+    std::size_t poissonCDFInverse(double mean, double x, double* conditionalUniform = nullptr);
+
+    /*Simulate a variable of the Bessel distribution of index nu > -1 and argument z >= 0, whose probabilities
+    are (z/2)^(2n+nu)/(I_nu(z) n! Gamma(n+nu+1)). The probabilities are computed from the mode by their ratios,
+    which avoids the Bessel function, and the cost grows like sqrt(z) */
+    std::size_t simulateBesselRandomVariable(double nu, double z, RandomStream& stream = generator);
 
     double newtonMethod(double initialGuess, std::function<double(double)> f, std::function<double(double)> fPrime, double precision = pow(10,-5));
 
@@ -69,4 +69,73 @@ double HestonModel::getInitialVolatility() const
 double HestonModel::getInitialAssetValue() const
 {
     return initialAssetValue_;
-}
\ No newline at end of file
+}
+
+HestonModelBatch::HestonModelBatch(const std::vector<HestonModel>& hestonModels)
+{
+    for(std::size_t i = 0; i < hestonModels.size(); i++)
+        addModel(hestonModels[i]);
+}
+
+void HestonModelBatch::addModel(const HestonModel& hestonModel)
+{
+    riskFreeRates_.push_back(hestonModel.getRiskFreeRate());
+    drifts_.push_back(hestonModel.getDrift());
+    meanReversionSpeeds_.push_back(hestonModel.getMeanReversionSpeed());
+    meanReversionLevels_.push_back(hestonModel.getMeanReversionLevel());
+    volOfVols_.push_back(hestonModel.getVolOfVol());
+    correlations_.push_back(hestonModel.getCorrelation());
+    initialVolatilities_.push_back(hestonModel.getInitialVolatility());
+    initialAssetValues_.push_back(hestonModel.getInitialAssetValue());
+}
+
+std::size_t HestonModelBatch::size() const
+{
+    return riskFreeRates_.size();
+}
+
+HestonModel HestonModelBatch::getModel(std::size_t i) const
+{
+    return HestonModel(riskFreeRates_[i], drifts_[i], meanReversionSpeeds_[i], meanReversionLevels_[i],
+                       volOfVols_[i], correlations_[i], initialVolatilities_[i], initialAssetValues_[i]);
+}
+
+const std::vector<double>& HestonModelBatch::getRiskFreeRates() const
+{
+    return riskFreeRates_;
+}
+
+const std::vector<double>& HestonModelBatch::getDrifts() const
+{
+    return drifts_;
+}
+
+const std::vector<double>& HestonModelBatch::getMeanReversionSpeeds() const
+{
+    return meanReversionSpeeds_;
+}
+
+const std::vector<double>& HestonModelBatch::getMeanReversionLevels() const
+{
+    return meanReversionLevels_;
+}
+
+const std::vector<double>& HestonModelBatch::getVolOfVols() const
+{
+    return volOfVols_;
+}
+
+const std::vector<double>& HestonModelBatch::getCorrelations() const
+{
+    return correlations_;
+}
+
+const std::vector<double>& HestonModelBatch::getInitialVolatilities() const
+{
+    return initialVolatilities_;
+}
+
+const std::vector<double>& HestonModelBatch::getInitialAssetValues() const
+{
+    return initialAssetValues_;
+}
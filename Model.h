@@ -1,6 +1,8 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <vector>
+
 
 class HestonModel
 {
@@ -33,4 +35,33 @@ public:
     double getInitialAssetValue() const;
 };
 
+/*Set of Heston models stored parameter by parameter (structure of arrays), so that the batch pricers
+can process the models in SIMD lanes */
+class HestonModelBatch
+{
+private:
+    std::vector<double> riskFreeRates_;
+    std::vector<double> drifts_;
+    std::vector<double> meanReversionSpeeds_;
+    std::vector<double> meanReversionLevels_;
+    std::vector<double> volOfVols_;
+    std::vector<double> correlations_;
+    std::vector<double> initialVolatilities_;
+    std::vector<double> initialAssetValues_;
+public:
+    HestonModelBatch() = default;
+    HestonModelBatch(const std::vector<HestonModel>& hestonModels);
+    void addModel(const HestonModel& hestonModel);
+    std::size_t size() const;
+    HestonModel getModel(std::size_t i) const;
+    const std::vector<double>& getRiskFreeRates() const;
+    const std::vector<double>& getDrifts() const;
+    const std::vector<double>& getMeanReversionSpeeds() const;
+    const std::vector<double>& getMeanReversionLevels() const;
+    const std::vector<double>& getVolOfVols() const;
+    const std::vector<double>& getCorrelations() const;
+    const std::vector<double>& getInitialVolatilities() const;
+    const std::vector<double>& getInitialAssetValues() const;
+};
+
 #endif // !MODEL_H
\ No newline at end of file
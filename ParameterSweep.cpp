@@ -0,0 +1,296 @@
+#include "ParameterSweep.h"
+#include "TimeGrid.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    std::string schemeName(VarianceScheme scheme)
+    {
+        switch(scheme)
+        {
+            case VarianceScheme::TruncatedGaussian: return "BKTG";
+            case VarianceScheme::QuadraticExponential: return "BKQE";
+            case VarianceScheme::NoncentralChiSquare: return "BKNCX2";
+            case VarianceScheme::Exact: return "NCX2GE";
+        }
+        return "";
+    }
+
+    //Settings of a point that determine its model and variance swap
+    std::vector<double> pricingKey(const SweepPoint& point)
+    {
+        return {point.riskFreeRate, point.drift, point.meanReversionSpeed, point.meanReversionLevel,
+                point.volOfVol, point.correlation, point.initialVolatility, point.initialAssetValue,
+                point.maturity, double(point.varianceSwap().getDates().size())};
+    }
+
+    //Settings of a point that determine its path simulator for the scheme of index schemeIdx
+    std::vector<double> simulatorKey(const SweepPoint& point, std::size_t schemeIdx)
+    {
+        std::vector<double> key = pricingKey(point);
+        key.push_back(double(point.nbTimePointsPerPeriod));
+        key.push_back(double(point.adaptiveTimeGrid));
+        key.push_back(double(schemeIdx));
+        return key;
+    }
+
+    /*Object shared by the points with the same key. It is built once by the first point needing it and
+    freed by the last one */
+    template<typename T>
+    struct SharedEntry
+    {
+        std::once_flag built;
+        std::unique_ptr<T> value;
+        std::atomic<std::size_t> remainingUses;
+
+        SharedEntry(): remainingUses(0) {}
+    };
+
+    template<typename T>
+    class SharedCache
+    {
+    private:
+        std::map<std::vector<double>, std::unique_ptr<SharedEntry<T>>> entries_;
+    public:
+        //Method counting one more use of the entry of key, before the sweep starts
+        void addUse(const std::vector<double>& key)
+        {
+            std::unique_ptr<SharedEntry<T>>& entry = entries_[key];
+            if(!entry)
+                entry.reset(new SharedEntry<T>());
+            entry->remainingUses++;
+        }
+        /*Method returning the object of key, built by build() if this is the first use. The map isn't modified
+        once the sweep has started, so that it can be read by all the threads without lock */
+        template<typename Builder>
+        const T& acquire(const std::vector<double>& key, Builder build)
+        {
+            SharedEntry<T>& entry = *entries_.at(key);
+            std::call_once(entry.built, [&entry, &build]() { entry.value.reset(build()); });
+            return *entry.value;
+        }
+        void release(const std::vector<double>& key)
+        {
+            SharedEntry<T>& entry = *entries_.at(key);
+            if(--entry.remainingUses == 0)
+                entry.value.reset();
+        }
+    };
+
+    struct AnalyticalPrices
+    {
+        double price;
+        double continuousPrice;
+    };
+}
+
+void SweepPoint::set(SweepParameter parameter, double value)
+{
+    switch(parameter)
+    {
+        case SweepParameter::MeanReversionSpeed: meanReversionSpeed = value; break;
+        case SweepParameter::MeanReversionLevel: meanReversionLevel = value; break;
+        case SweepParameter::VolOfVol: volOfVol = value; break;
+        case SweepParameter::Correlation: correlation = value; break;
+        case SweepParameter::InitialVolatility: initialVolatility = value; break;
+        case SweepParameter::Maturity: maturity = value; break;
+        case SweepParameter::NbOfObservationsPerYear: nbOfObservationsPerYear = value; break;
+        case SweepParameter::NbTimePointsPerPeriod: nbTimePointsPerPeriod = std::size_t(value); break;
+        case SweepParameter::AdaptiveTimeGrid: adaptiveTimeGrid = value != 0.; break;
+        case SweepParameter::NbSimulations: nbSimulations = std::size_t(value); break;
+    }
+}
+
+HestonModel SweepPoint::hestonModel() const
+{
+    return HestonModel(riskFreeRate, drift, meanReversionSpeed, meanReversionLevel, volOfVol, correlation,
+                       initialVolatility, initialAssetValue);
+}
+
+VarianceSwap SweepPoint::varianceSwap() const
+{
+    return VarianceSwap(maturity, std::size_t(std::round(nbOfObservationsPerYear*maturity))+1);
+}
+
+std::vector<double> SweepPoint::timePoints() const
+{
+    if(adaptiveTimeGrid)
+        return TimeGrid(varianceSwap().getDates(), nbTimePointsPerPeriod, hestonModel()).getTimePoints();
+    return TimeGrid(varianceSwap().getDates(), nbTimePointsPerPeriod).getTimePoints();
+}
+
+ParameterSweep::ParameterSweep(const SweepPoint& basePoint, const std::vector<VarianceScheme>& schemes,
+                               std::size_t nbThreads):
+        basePoint_(basePoint),
+        schemes_(schemes),
+        nbThreads_(nbThreads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : nbThreads)
+{
+
+}
+
+void ParameterSweep::addAxis(SweepParameter parameter, const std::vector<double>& values)
+{
+    axes_.push_back(std::make_pair(parameter, values));
+}
+
+void ParameterSweep::addPoint(const SweepPoint& point)
+{
+    listedPoints_.push_back(point);
+}
+
+std::vector<SweepPoint> ParameterSweep::points() const
+{
+    std::vector<SweepPoint> gridPoints;
+    if(!axes_.empty())
+        gridPoints.push_back(basePoint_);
+    //Each axis multiplies the points built with the previous ones, the last axis varying the fastest
+    for(std::size_t axisIdx = 0; axisIdx < axes_.size(); axisIdx++)
+    {
+        std::vector<SweepPoint> newGridPoints;
+        for(std::size_t pointIdx = 0; pointIdx < gridPoints.size(); pointIdx++)
+        {
+            for(std::size_t valueIdx = 0; valueIdx < axes_[axisIdx].second.size(); valueIdx++)
+            {
+                SweepPoint point = gridPoints[pointIdx];
+                point.set(axes_[axisIdx].first, axes_[axisIdx].second[valueIdx]);
+                newGridPoints.push_back(point);
+            }
+        }
+        gridPoints = newGridPoints;
+    }
+
+    std::vector<SweepPoint> points = listedPoints_;
+    points.insert(points.end(), gridPoints.begin(), gridPoints.end());
+    return points;
+}
+
+std::vector<SweepResult> ParameterSweep::run() const
+{
+    std::vector<SweepPoint> points = this->points();
+
+    SharedCache<AnalyticalPrices> analyticalPricesCache;
+    SharedCache<HestonLogSpotPathSimulator> simulatorsCache;
+    for(std::size_t pointIdx = 0; pointIdx < points.size(); pointIdx++)
+    {
+        analyticalPricesCache.addUse(pricingKey(points[pointIdx]));
+        for(std::size_t schemeIdx = 0; schemeIdx < schemes_.size() && points[pointIdx].nbSimulations > 0; schemeIdx++)
+            simulatorsCache.addUse(simulatorKey(points[pointIdx], schemeIdx));
+    }
+
+    std::vector<SweepResult> results(points.size());
+    auto priceAt = [&](std::size_t pointIdx)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const SweepPoint& point = points[pointIdx];
+        HestonModel hestonModel = point.hestonModel();
+        VarianceSwap varianceSwap = point.varianceSwap();
+        SweepResult& result = results[pointIdx];
+        result.point = point;
+
+        std::vector<double> key = pricingKey(point);
+        const AnalyticalPrices& analyticalPrices = analyticalPricesCache.acquire(key, [&]()
+        {
+            VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+            return new AnalyticalPrices{anPricer.price(varianceSwap), anPricer.continousPrice(varianceSwap)};
+        });
+        result.analyticalPrice = analyticalPrices.price;
+        result.continuousAnalyticalPrice = analyticalPrices.continuousPrice;
+        analyticalPricesCache.release(key);
+
+        for(std::size_t schemeIdx = 0; schemeIdx < schemes_.size() && point.nbSimulations > 0; schemeIdx++)
+        {
+            key = simulatorKey(point, schemeIdx);
+            const HestonLogSpotPathSimulator& pathSimulator = simulatorsCache.acquire(key,
+                                                                [&]() -> HestonLogSpotPathSimulator*
+            {
+                if(schemes_[schemeIdx] == VarianceScheme::Exact)
+                    return new GammaExpansionScheme(NoncentralChiSquareScheme(varianceSwap.getDates(), hestonModel));
+                std::vector<double> timePoints = point.timePoints();
+                if(schemes_[schemeIdx] == VarianceScheme::TruncatedGaussian)
+                    return new BroadieKayaScheme(TruncatedGaussianScheme(timePoints, hestonModel));
+                if(schemes_[schemeIdx] == VarianceScheme::NoncentralChiSquare)
+                    return new BroadieKayaScheme(NoncentralChiSquareScheme(timePoints, hestonModel));
+                return new BroadieKayaScheme(QuadraticExponentialScheme(timePoints, hestonModel));
+            });
+            //The points are already priced in parallel : each of them uses a single thread
+            VarianceSwapsHestonMonteCarloPricer mcPricer(pathSimulator, point.nbSimulations);
+            result.monteCarloEstimates.push_back(mcPricer.estimate(varianceSwap));
+            simulatorsCache.release(key);
+        }
+        result.computationTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    };
+
+    /*The points are dealt dynamically, since their costs can be very different, and grouped by shared
+    objects so that these are freed early */
+    std::vector<std::size_t> order(points.size());
+    std::vector<std::vector<double>> orderKeys(points.size());
+    for(std::size_t pointIdx = 0; pointIdx < points.size(); pointIdx++)
+    {
+        order[pointIdx] = pointIdx;
+        orderKeys[pointIdx] = simulatorKey(points[pointIdx], 0);
+    }
+    std::stable_sort(order.begin(), order.end(), [&orderKeys](std::size_t i, std::size_t j)
+    {
+        return orderKeys[i] < orderKeys[j];
+    });
+    std::atomic<std::size_t> nextPointIdx(0);
+    auto work = [&]()
+    {
+        for(std::size_t orderIdx = nextPointIdx++; orderIdx < points.size(); orderIdx = nextPointIdx++)
+            priceAt(order[orderIdx]);
+    };
+    std::vector<std::thread> workers;
+    for(std::size_t threadIdx = 1; threadIdx < std::min(nbThreads_, points.size()); threadIdx++)
+        workers.push_back(std::thread(work));
+    work();
+    for(std::size_t threadIdx = 0; threadIdx < workers.size(); threadIdx++)
+        workers[threadIdx].join();
+    return results;
+}
+
+void ParameterSweep::writeCsv(const std::string& fileName, const std::vector<SweepResult>& results) const
+{
+    std::ofstream file;
+    file.open(fileName);
+    file << "kappa;theta;eps;rho;V0;Maturite;Observations par an;Points par periode;Grille adaptative;Nombre de simulations;"
+         << "Prix Analytique;Prix Analytique Continu";
+    for(std::size_t schemeIdx = 0; schemeIdx < schemes_.size(); schemeIdx++)
+        file << ";Prix " << schemeName(schemes_[schemeIdx]) << ";Erreur " << schemeName(schemes_[schemeIdx]);
+    file << ";Temps (s) \n";
+
+    for(std::size_t resultIdx = 0; resultIdx < results.size(); resultIdx++)
+    {
+        const SweepResult& result = results[resultIdx];
+        const SweepPoint& point = result.point;
+        file << point.meanReversionSpeed << ";";
+        file << point.meanReversionLevel << ";";
+        file << point.volOfVol << ";";
+        file << point.correlation << ";";
+        file << point.initialVolatility << ";";
+        file << point.maturity << ";";
+        file << point.nbOfObservationsPerYear << ";";
+        file << point.nbTimePointsPerPeriod << ";";
+        file << point.adaptiveTimeGrid << ";";
+        file << point.nbSimulations << ";";
+        file << result.analyticalPrice << ";";
+        file << result.continuousAnalyticalPrice;
+        for(std::size_t schemeIdx = 0; schemeIdx < schemes_.size(); schemeIdx++)
+        {
+            if(schemeIdx < result.monteCarloEstimates.size())
+                file << ";" << result.monteCarloEstimates[schemeIdx].price
+                     << ";" << result.monteCarloEstimates[schemeIdx].standardError;
+            else
+                file << ";;";
+        }
+        file << ";" << result.computationTime << "\n";
+    }
+    file.close();
+}
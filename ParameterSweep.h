@@ -0,0 +1,111 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "VarianceSwapsHestonAnalyticalPricer.h"
+#include "VarianceSwapsHestonMonteCarloPricer.h"
+
+/*Variance schemes used for the Monte Carlo prices of a sweep. The first three are combined with the Broadie-Kaya
+scheme for the log-spot on the grid of the point, the exact one with the gamma expansion on the observation dates only */
+enum class VarianceScheme
+{
+    TruncatedGaussian,
+    QuadraticExponential,
+    NoncentralChiSquare,
+    Exact
+};
+
+//Settings of a point that a sweep can vary
+enum class SweepParameter
+{
+    MeanReversionSpeed,
+    MeanReversionLevel,
+    VolOfVol,
+    Correlation,
+    InitialVolatility,
+    Maturity,
+    NbOfObservationsPerYear,
+    NbTimePointsPerPeriod,
+    AdaptiveTimeGrid,
+    NbSimulations
+};
+
+//Point of a sweep : Heston model, variance swap and Monte Carlo settings
+struct SweepPoint
+{
+    double riskFreeRate = 0.;
+    double drift = 0.;
+    double meanReversionSpeed = 0.5;
+    double meanReversionLevel = 0.04;
+    double volOfVol = 1.;
+    double correlation = -0.9;
+    double initialVolatility = 0.04;
+    double initialAssetValue = 100.;
+
+    //The variance swap has round(nbOfObservationsPerYear*maturity)+1 equally spaced dates
+    double maturity = 1.;
+    double nbOfObservationsPerYear = 2.;
+
+    //Number of points of the simulation grid between two dates, both included
+    std::size_t nbTimePointsPerPeriod = 100;
+    //If true, the same number of steps is distributed by the adaptive TimeGrid instead of uniformly
+    bool adaptiveTimeGrid = false;
+    //If 0, only the analytical prices are computed
+    std::size_t nbSimulations = 0;
+
+    void set(SweepParameter parameter, double value);
+    HestonModel hestonModel() const;
+    VarianceSwap varianceSwap() const;
+    //Simulation grid : nbTimePointsPerPeriod points on each period of the variance swap on average
+    std::vector<double> timePoints() const;
+};
+
+//Prices of a point of a sweep
+struct SweepResult
+{
+    SweepPoint point;
+    double analyticalPrice;
+    double continuousAnalyticalPrice;
+    //One estimate per variance scheme of the sweep, empty if the point has no simulation
+    std::vector<MonteCarloEstimate> monteCarloEstimates;
+    //Wall-clock time spent on the point (in seconds), including the construction of shared objects
+    double computationTime;
+};
+
+/*Runner pricing a variance swap for every point of a grid. The grid is made of listed points and of the
+Cartesian product of the axes applied to a base point.
+The points are dealt to a pool of threads, each point being priced on a single thread. The objects
+which only depend on part of the settings of a point are built once and shared by the points with
+the same settings : the analytical prices for the points with the same model and variance swap, and
+the path simulators for those which also have the same simulation grid. A shared simulator is freed
+as soon as the last point using it has been priced, so that the memory doesn't grow with the sweep.
+The Monte Carlo prices only depend on the seed and on the point, not on the thread pricing it */
+class ParameterSweep
+{
+private:
+    SweepPoint basePoint_;
+    std::vector<std::pair<SweepParameter, std::vector<double>>> axes_;
+    std::vector<SweepPoint> listedPoints_;
+    std::vector<VarianceScheme> schemes_;
+    std::size_t nbThreads_;
+public:
+    ParameterSweep(const SweepPoint& basePoint,
+                   const std::vector<VarianceScheme>& schemes = {},
+                   //By default, one thread per core
+                   std::size_t nbThreads = 0);
+
+    //Method adding an axis to the Cartesian grid : the points of the grid take all the values of each axis
+    void addAxis(SweepParameter parameter, const std::vector<double>& values);
+    void addPoint(const SweepPoint& point);
+    //Listed points followed by the points of the Cartesian grid (none if there is no axis)
+    std::vector<SweepPoint> points() const;
+
+    //Method returning the results of the points, in the order of points()
+    std::vector<SweepResult> run() const;
+    //Method writing results in a csv file, one line per point
+    void writeCsv(const std::string& fileName, const std::vector<SweepResult>& results) const;
+};
+
+#endif
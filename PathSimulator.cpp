@@ -15,4 +15,17 @@ PathSimulator::~PathSimulator()
 std::vector<double> PathSimulator::getTimePoints() const
 {
 	return timePoints_;
-}
\ No newline at end of file
+}
+
+bool PathSimulator::drawsAdditionalRandomVariables() const
+{
+	return false;
+}
+
+double PathSimulator::simulateRandomVariable(RandomVariableType type, RandomStream& stream)
+{
+	if(type == RandomVariableType::Uniform)
+		return MathFunctions::simulateUniformRandomVariable(stream);
+	else
+		return MathFunctions::simulateZigguratGaussianRandomVariable(stream);
+}
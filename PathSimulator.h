@@ -4,6 +4,16 @@
 #include <vector>
 #include <random>
 #include "Model.h"
+#include "MathFunctions.h"
+
+//Distribution of the random variable consumed by one step of a scheme
+enum class RandomVariableType
+{
+    Uniform,  //Uniform on [0,1]
+    Gaussian  //Standard Gaussian
+};
+
+class RandomVariablesGenerator;
 
 //Abstract class
 class PathSimulator
@@ -11,14 +21,25 @@ class PathSimulator
 protected:
     double initialValue_; // Each simulated path starts from the same initial value.
     std::vector<double> timePoints_; // Time interval which is dicretized in points.
+
 public:
     PathSimulator(double initialValue, const std::vector<double>& timePoints);
     virtual ~PathSimulator();
     virtual PathSimulator* clone() const = 0;
 
-    //Method simulating a random path
-    virtual std::vector<double> path() const = 0; 
+    //Method simulating a random path, whose random variables are drawn from stream
+    virtual std::vector<double> path(RandomStream& stream = MathFunctions::generator) const = 0; 
+    /*Method simulating a block of randomVariablesGenerator.getNbPaths() random paths advanced together,
+    one time step at a time, with the random variables of the generator. The block is stored
+    time-major : the value of path p at time index t is pathBlock[t*nbPaths+p] */
+    virtual std::vector<double> pathBlock(RandomVariablesGenerator& randomVariablesGenerator) const = 0;
     std::vector<double> getTimePoints() const;
+    /*Whether a step draws additional random variables beyond its pre-drawn one (false by default). The path
+    engines only fetch the auxiliary streams of the generator for such schemes */
+    virtual bool drawsAdditionalRandomVariables() const;
+
+    //Draws a random variable of the given type from stream
+    static double simulateRandomVariable(RandomVariableType type, RandomStream& stream);
 };
 
 #endif // !
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "RandomStream.h"
+
+RandomStream::RandomStream(std::uint64_t seed, std::uint64_t streamIndex, std::uint64_t position)
+{
+    key_[0] = std::uint32_t(seed);
+    key_[1] = std::uint32_t(seed >> 32);
+    seek(streamIndex, position);
+}
+
+void RandomStream::seek(std::uint64_t streamIndex, std::uint64_t position)
+{
+    streamIndex_ = streamIndex;
+    position_ = position;
+    //The block containing the position is only evaluated if we start in its middle
+    if(position_ % 2 == 1)
+        refill();
+}
+
+std::uint64_t RandomStream::getStreamIndex() const
+{
+    return streamIndex_;
+}
+
+std::uint64_t RandomStream::getPosition() const
+{
+    return position_;
+}
+
+double RandomStream::nextUniform()
+{
+    if(position_ % 2 == 0)
+        refill();
+    return buffer_[position_++ % 2];
+}
+
+std::uint64_t RandomStream::nextBits()
+{
+    if(position_ % 2 == 0)
+        refill();
+    return words_[position_++ % 2];
+}
+
+void RandomStream::refill()
+{
+    //The counter is made of the index of the block in the stream and of the index of the stream
+    std::uint64_t block = position_/2;
+    std::uint32_t counter[4] = {std::uint32_t(block), std::uint32_t(block >> 32),
+                                std::uint32_t(streamIndex_), std::uint32_t(streamIndex_ >> 32)};
+    philox(counter, key_);
+
+    //Each uniform is built from the 53 upper bits of a 64 bits word, shifted by half a unit
+    //so that neither 0 nor 1 can be drawn
+    for(int i = 0; i < 2; i++)
+    {
+        words_[i] = (std::uint64_t(counter[2*i]) << 32) | counter[2*i+1];
+        buffer_[i] = (double(words_[i] >> 11) + 0.5)*(1.0/9007199254740992.0);
+    }
+}
+
+void RandomStream::philox(std::uint32_t counter[4], const std::uint32_t key[2])
+{
+    const std::uint32_t multiplier0 = 0xD2511F53, multiplier1 = 0xCD9E8D57;
+    const std::uint32_t weyl0 = 0x9E3779B9, weyl1 = 0xBB67AE85;
+    std::uint32_t key0 = key[0], key1 = key[1];
+    for(int round = 0; round < 10; round++)
+    {
+        std::uint64_t product0 = std::uint64_t(multiplier0)*counter[0];
+        std::uint64_t product1 = std::uint64_t(multiplier1)*counter[2];
+        std::uint32_t c1 = counter[1], c3 = counter[3];
+        counter[0] = std::uint32_t(product1 >> 32)^c1^key0;
+        counter[1] = std::uint32_t(product1);
+        counter[2] = std::uint32_t(product0 >> 32)^c3^key1;
+        counter[3] = std::uint32_t(product0);
+        key0 += weyl0;
+        key1 += weyl1;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#include <cstdint>
+
+/*Counter-based random number generator (Philox4x32-10, Salmon et al. 2011).
+A draw is a pure function of (seed, stream index, position) : streams don't share any state,
+so that each thread, path or trade can use its own stream, and any position of any stream
+can be reached in O(1). Two uniforms are produced per evaluation of the bijection */
+class RandomStream
+{
+private:
+    std::uint32_t key_[2];
+    std::uint64_t streamIndex_;
+    //Index of the next uniform to be drawn in the stream
+    std::uint64_t position_;
+    //Uniforms produced by the last evaluation of the bijection
+    double buffer_[2];
+
+    //Philox4x32-10 bijection applied to counter with the given key
+    static void philox(std::uint32_t counter[4], const std::uint32_t key[2]);
+    //Raw 64 bits words produced by the last evaluation of the bijection
+    std::uint64_t words_[2];
+
+    //Evaluates the bijection for the block of the current position
+    void refill();
+public:
+    RandomStream(std::uint64_t seed = 0, std::uint64_t streamIndex = 0, std::uint64_t position = 0);
+
+    //Jumps to the given position (counted in uniforms) of the given stream
+    void seek(std::uint64_t streamIndex, std::uint64_t position = 0);
+    std::uint64_t getStreamIndex() const;
+    std::uint64_t getPosition() const;
+
+    //Uniform random variable on the open interval (0,1)
+    double nextUniform();
+    //64 random bits, drawn at the same position as nextUniform (the uniform is built from the 53 upper bits)
+    std::uint64_t nextBits();
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include "RandomVariablesGenerator.h"
+#include "MathFunctions.h"
+
+namespace
+{
+    //Maximum number of Brownian bridge variables per factor taken from the Sobol sequence
+    const std::size_t maxQuasiRandomDimensionsPerFactor = 32;
+    //The streams used by the quasi-random generator are placed after those of the paths
+    const std::uint64_t quasiRandomStreamsOffset = std::uint64_t(1) << 63;
+}
+
+RandomVariablesGenerator::~RandomVariablesGenerator()
+{
+
+}
+
+void RandomVariablesGenerator::seekStep(RandomStream& stream, std::size_t stepIndex)
+{
+    if(stream.getPosition() >> 32 != stepIndex)
+        stream.seek(stream.getStreamIndex(), std::uint64_t(stepIndex) << 32);
+}
+
+void RandomVariablesGenerator::seekAuxiliary(RandomStream& stream, std::size_t stepIndex, std::size_t factor)
+{
+    //The first half of the segment holds the random variables of simulateRandomVariables, each factor owning a
+    //quarter of the second half
+    stream.seek(stream.getStreamIndex(), (std::uint64_t(stepIndex) << 32) | (std::uint64_t(1) << 31)
+                                         | (std::uint64_t(factor) << 30));
+}
+
+PseudoRandomVariablesGenerator::PseudoRandomVariablesGenerator(std::uint64_t seed,
+                                                               std::uint64_t firstPath,
+                                                               std::size_t nbPaths)
+{
+    for(std::size_t p = 0; p < nbPaths; p++)
+        streams_.push_back(RandomStream(seed, firstPath+p));
+}
+
+PseudoRandomVariablesGenerator* PseudoRandomVariablesGenerator::clone() const
+{
+    return new PseudoRandomVariablesGenerator(*this);
+}
+
+std::size_t PseudoRandomVariablesGenerator::getNbPaths() const
+{
+    return streams_.size();
+}
+
+void PseudoRandomVariablesGenerator::simulateRandomVariables(std::size_t stepIndex, std::size_t /*factor*/,
+                                                             RandomVariableType type, double* randomVariables)
+{
+    for(std::size_t p = 0; p < streams_.size(); p++)
+    {
+        seekStep(streams_[p], stepIndex);
+        randomVariables[p] = PathSimulator::simulateRandomVariable(type, streams_[p]);
+    }
+}
+
+RandomStream* PseudoRandomVariablesGenerator::auxiliaryStreams(std::size_t stepIndex, std::size_t factor)
+{
+    auxiliaryStreams_[factor] = streams_;
+    for(std::size_t p = 0; p < auxiliaryStreams_[factor].size(); p++)
+        seekAuxiliary(auxiliaryStreams_[factor][p], stepIndex, factor);
+    return auxiliaryStreams_[factor].data();
+}
+
+AntitheticRandomVariablesGenerator::AntitheticRandomVariablesGenerator(std::uint64_t seed,
+                                                                       std::uint64_t firstPair,
+                                                                       std::size_t nbPairs)
+{
+    for(std::size_t p = 0; p < nbPairs; p++)
+        streams_.push_back(RandomStream(seed, firstPair+p));
+}
+
+AntitheticRandomVariablesGenerator* AntitheticRandomVariablesGenerator::clone() const
+{
+    return new AntitheticRandomVariablesGenerator(*this);
+}
+
+std::size_t AntitheticRandomVariablesGenerator::getNbPaths() const
+{
+    return 2*streams_.size();
+}
+
+void AntitheticRandomVariablesGenerator::simulateRandomVariables(std::size_t stepIndex, std::size_t /*factor*/,
+                                                                 RandomVariableType type, double* randomVariables)
+{
+    std::size_t nbPairs = streams_.size();
+    for(std::size_t p = 0; p < nbPairs; p++)
+    {
+        seekStep(streams_[p], stepIndex);
+        double randomVariable = PathSimulator::simulateRandomVariable(type, streams_[p]);
+        randomVariables[p] = randomVariable;
+        randomVariables[nbPairs+p] = type == RandomVariableType::Gaussian ? -randomVariable : 1.-randomVariable;
+    }
+}
+
+RandomStream* AntitheticRandomVariablesGenerator::auxiliaryStreams(std::size_t stepIndex, std::size_t factor)
+{
+    std::size_t nbPairs = streams_.size();
+    auxiliaryStreams_[factor].resize(2*nbPairs);
+    for(std::size_t p = 0; p < nbPairs; p++)
+    {
+        auxiliaryStreams_[factor][p] = streams_[p];
+        seekAuxiliary(auxiliaryStreams_[factor][p], stepIndex, factor);
+        auxiliaryStreams_[factor][nbPairs+p] = auxiliaryStreams_[factor][p];
+    }
+    return auxiliaryStreams_[factor].data();
+}
+
+QuasiRandomVariablesGenerator::QuasiRandomVariablesGenerator(const SobolSequence& sobolSequence,
+                                                             const BrownianBridge& bridge,
+                                                             std::uint64_t seed,
+                                                             std::uint64_t replicateIndex,
+                                                             std::uint64_t firstPoint,
+                                                             std::size_t nbPaths):
+    bridge_(&bridge), nbPaths_(nbPaths), currentValues_(2*nbPaths, 0.)
+{
+    std::size_t dimension = sobolSequence.getDimension();
+    std::size_t nbQuasiRandom = dimension/2;
+    coarseIndexes_ = bridge.coarseIndexes(nbQuasiRandom);
+    coarseValues_.resize(2*nbPaths*nbQuasiRandom);
+    nextCoarse_[0] = nextCoarse_[1] = 0;
+
+    //Digital shift of the replicate
+    RandomStream shiftStream(seed, quasiRandomStreamsOffset + (replicateIndex << 32));
+    std::vector<std::uint32_t> shifts(dimension);
+    for(std::size_t d = 0; d < dimension; d++)
+        shifts[d] = std::uint32_t(shiftStream.nextBits() >> 32);
+
+    std::vector<std::uint32_t> coordinates(dimension);
+    std::vector<double> uniforms(dimension), gaussians(nbQuasiRandom), path(bridge.getNbSteps());
+    sobolSequence.point(firstPoint, coordinates.data());
+    for(std::size_t p = 0; p < nbPaths; p++)
+    {
+        if(p > 0)
+            sobolSequence.nextPoint(firstPoint+p, coordinates.data());
+        for(std::size_t d = 0; d < dimension; d++)
+            uniforms[d] = (double(coordinates[d]^shifts[d]) + 0.5)/4294967296.0;
+
+        for(std::size_t factor = 0; factor < 2; factor++)
+        {
+            //The coarsest points of the bridge come from the Sobol point
+            MathFunctions::normalCDFInverse(&uniforms[factor*nbQuasiRandom], gaussians.data(), nbQuasiRandom);
+            bridge.coarseTransform(gaussians.data(), nbQuasiRandom, path.data());
+            for(std::size_t j = 0; j < nbQuasiRandom; j++)
+                coarseValues_[(factor*nbPaths+p)*nbQuasiRandom+j] = path[coarseIndexes_[j]];
+        }
+        streams_.push_back(RandomStream(seed, quasiRandomStreamsOffset + (replicateIndex << 32)
+                                              + ((firstPoint+p) << 1 | 1)));
+    }
+}
+
+QuasiRandomVariablesGenerator* QuasiRandomVariablesGenerator::clone() const
+{
+    return new QuasiRandomVariablesGenerator(*this);
+}
+
+std::size_t QuasiRandomVariablesGenerator::getNbPaths() const
+{
+    return nbPaths_;
+}
+
+void QuasiRandomVariablesGenerator::simulateRandomVariables(std::size_t stepIndex, std::size_t factor,
+                                                            RandomVariableType type, double* randomVariables)
+{
+    std::size_t nbCoarse = coarseIndexes_.size();
+    std::size_t& nextCoarse = nextCoarse_[factor];
+    if(coarseIndexes_[nextCoarse] < stepIndex)
+        nextCoarse++;
+    double weight, stdDev;
+    bridge_->fineStep(stepIndex, coarseIndexes_[nextCoarse], weight, stdDev);
+    double sqrtStepLength = std::sqrt(bridge_->getStepLength(stepIndex));
+
+    for(std::size_t p = 0; p < nbPaths_; p++)
+    {
+        //The finest points of the bridge are pseudo-random
+        double& currentValue = currentValues_[factor*nbPaths_+p];
+        double increment = weight*(coarseValues_[(factor*nbPaths_+p)*nbCoarse+nextCoarse] - currentValue);
+        if(stdDev > 0.)
+        {
+            seekStep(streams_[p], stepIndex);
+            increment += stdDev*MathFunctions::simulateZigguratGaussianRandomVariable(streams_[p]);
+        }
+        currentValue += sqrtStepLength*increment;
+
+        //The uniforms are kept away from 1, which the normal cdf reaches numerically in the far right tail
+        if(type == RandomVariableType::Uniform)
+            randomVariables[p] = std::min(MathFunctions::normalCDF(increment), 1.0-1.0/9007199254740992.0);
+        else
+            randomVariables[p] = increment;
+    }
+}
+
+RandomStream* QuasiRandomVariablesGenerator::auxiliaryStreams(std::size_t stepIndex, std::size_t factor)
+{
+    auxiliaryStreams_[factor] = streams_;
+    for(std::size_t p = 0; p < nbPaths_; p++)
+        seekAuxiliary(auxiliaryStreams_[factor][p], stepIndex, factor);
+    return auxiliaryStreams_[factor].data();
+}
+
+std::size_t QuasiRandomVariablesGenerator::nbQuasiRandomDimensions(std::size_t nbSteps)
+{
+    return 2*std::min(nbSteps, maxQuasiRandomDimensionsPerFactor);
+}
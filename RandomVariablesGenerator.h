@@ -0,0 +1,115 @@
+#ifndef RANDOMVARIABLESGENERATOR_H
+#define RANDOMVARIABLESGENERATOR_H
+
+#include <vector>
+#include <cstdint>
+#include "PathSimulator.h"
+#include "RandomStream.h"
+#include "SobolSequence.h"
+#include "BrownianBridge.h"
+
+//Abstract class : source of the random variables driving a block of paths advanced together
+class RandomVariablesGenerator
+{
+public:
+    virtual ~RandomVariablesGenerator();
+    /*Copy of the generator in its current state, which draws the same random variables as the
+    generator from then on */
+    virtual RandomVariablesGenerator* clone() const = 0;
+    virtual std::size_t getNbPaths() const = 0;
+
+    /*Fills randomVariables with one random variable of the given type per path of the block, driving
+    the factor `factor` (0 for the variance, 1 for the log-spot) from the time index stepIndex to
+    stepIndex+1. For each step, the variance is drawn before the log-spot */
+    virtual void simulateRandomVariables(std::size_t stepIndex, std::size_t factor,
+                                         RandomVariableType type, double* randomVariables) = 0;
+    /*Returns one stream per path of the block for the additional random variables of the factor `factor` from
+    stepIndex to stepIndex+1 whose number isn't known in advance (rejection sampling, Poisson counts). They stay
+    valid until the next call for the same factor. The stream of a path depends only on (seed, path, step, factor). It starts in the
+    second half of the segment of the step, after the random variables drawn by simulateRandomVariables */
+    virtual RandomStream* auxiliaryStreams(std::size_t stepIndex, std::size_t factor) = 0;
+protected:
+    //Streams returned by auxiliaryStreams for each factor
+    std::vector<RandomStream> auxiliaryStreams_[2];
+
+    /*Moves stream to the segment of the step stepIndex, unless it is already in it. Each step owns 2^32 positions
+    of the stream, so that its random variables only depend on (seed, path, step), and not on the number of
+    uniforms consumed by the rejections of the earlier steps. The factors of a step follow each other in its segment */
+    static void seekStep(RandomStream& stream, std::size_t stepIndex);
+    //Moves stream to the start of the additional random variables of the factor `factor` in the segment of the step
+    static void seekAuxiliary(RandomStream& stream, std::size_t stepIndex, std::size_t factor);
+};
+
+/*Independent pseudo-random variables : path p of the block draws from the stream firstPath+p of the seed, in the
+segment of the step */
+class PseudoRandomVariablesGenerator : public RandomVariablesGenerator
+{
+private:
+    std::vector<RandomStream> streams_;
+public:
+    PseudoRandomVariablesGenerator(std::uint64_t seed, std::uint64_t firstPath, std::size_t nbPaths);
+    PseudoRandomVariablesGenerator* clone() const;
+    std::size_t getNbPaths() const;
+    void simulateRandomVariables(std::size_t stepIndex, std::size_t factor,
+                                 RandomVariableType type, double* randomVariables);
+    RandomStream* auxiliaryStreams(std::size_t stepIndex, std::size_t factor);
+};
+
+/*Antithetic pseudo-random variables. The block is made of nbPairs paths drawn as in
+PseudoRandomVariablesGenerator, followed by their mirrors : the path nbPairs+p is driven by the
+opposites of the Gaussian variables of the path p, and by 1-U for its uniform variables U. Both paths of a pair
+draw their additional random variables from the same auxiliary stream */
+class AntitheticRandomVariablesGenerator : public RandomVariablesGenerator
+{
+private:
+    std::vector<RandomStream> streams_;
+public:
+    AntitheticRandomVariablesGenerator(std::uint64_t seed, std::uint64_t firstPair, std::size_t nbPairs);
+    AntitheticRandomVariablesGenerator* clone() const;
+    std::size_t getNbPaths() const;
+    void simulateRandomVariables(std::size_t stepIndex, std::size_t factor,
+                                 RandomVariableType type, double* randomVariables);
+    RandomStream* auxiliaryStreams(std::size_t stepIndex, std::size_t factor);
+};
+
+/*Randomized quasi-random variables. The Gaussian increments of each factor are built by a Brownian
+bridge whose first nbQuasiRandomDimensions variables are given by a Sobol point, the following ones
+being pseudo-random. The Sobol points are randomized by a digital shift specific to the replicate,
+so that independent replicates give an estimate of the integration error. Uniform variables are
+obtained from the Gaussian ones through the normal cdf.
+Only the values of the paths at the coarse indexes of the bridge, given by the Sobol points, are stored : the
+rest of each path is drawn one step at a time, so that the memory used doesn't depend on the number of steps.
+For each factor, the steps must be drawn in increasing order from the first one, as the path engines do */
+class QuasiRandomVariablesGenerator : public RandomVariablesGenerator
+{
+private:
+    const BrownianBridge* bridge_;
+    std::size_t nbPaths_;
+    std::vector<std::size_t> coarseIndexes_;
+    //Values of the Brownian motions at the coarse indexes, stored as coarseValues_[((factor*nbPaths_+p)*nbCoarse+j]
+    std::vector<double> coarseValues_;
+    //Values of the Brownian motions at the start of the next step, stored as currentValues_[factor*nbPaths_+p]
+    std::vector<double> currentValues_;
+    //Position in coarseIndexes_ of the next coarse index of each factor
+    std::size_t nextCoarse_[2];
+    //Streams of the pseudo-random variables of the paths
+    std::vector<RandomStream> streams_;
+public:
+    /*Generates the variables of the paths driven by the Sobol points firstPoint to firstPoint+nbPaths-1
+    of the replicate replicateIndex. The pseudo-random part of the path driven by the point i is
+    drawn from a stream of the seed which depends on the replicate and on i only. The bridge must outlive
+    the generator */
+    QuasiRandomVariablesGenerator(const SobolSequence& sobolSequence, const BrownianBridge& bridge,
+                                  std::uint64_t seed, std::uint64_t replicateIndex,
+                                  std::uint64_t firstPoint, std::size_t nbPaths);
+    QuasiRandomVariablesGenerator* clone() const;
+    std::size_t getNbPaths() const;
+    void simulateRandomVariables(std::size_t stepIndex, std::size_t factor,
+                                 RandomVariableType type, double* randomVariables);
+    RandomStream* auxiliaryStreams(std::size_t stepIndex, std::size_t factor);
+
+    //Number of dimensions of the Sobol sequence needed to drive nbSteps steps of the two factors
+    static std::size_t nbQuasiRandomDimensions(std::size_t nbSteps);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "SobolSequence.h"
+#include "RandomStream.h"
+
+namespace
+{
+    //Initial direction numbers m_1,...,m_s of the dimensions 2 to 21 (Joe and Kuo, new-joe-kuo-6.21201)
+    const std::uint32_t joeKuoInitialNumbers[20][7] = {
+        {1}, {1,3}, {1,3,1}, {1,1,1}, {1,1,3,3}, {1,3,5,13}, {1,1,5,5,17}, {1,1,5,5,5},
+        {1,1,7,11,19}, {1,1,5,1,1}, {1,1,1,3,11}, {1,3,5,5,31}, {1,3,3,9,7,49},
+        {1,1,1,15,21,21}, {1,3,1,13,27,49}, {1,1,1,15,7,5}, {1,3,1,15,13,25},
+        {1,1,5,5,19,61}, {1,3,7,11,23,15,103}, {1,3,7,13,13,15,69}};
+
+    //Product of two polynomials over GF(2) modulo the polynomial modulus of the given degree
+    std::uint64_t multiplyModulo(std::uint64_t a, std::uint64_t b, std::uint64_t modulus, int degree)
+    {
+        std::uint64_t result = 0;
+        while(b)
+        {
+            if(b & 1)
+                result ^= a;
+            b >>= 1;
+            a <<= 1;
+            if(a >> degree & 1)
+                a ^= modulus;
+        }
+        return result;
+    }
+
+    std::uint64_t powerModulo(std::uint64_t exponent, std::uint64_t modulus, int degree)
+    {
+        std::uint64_t result = 1, base = 2; //base is the polynomial x
+        while(exponent)
+        {
+            if(exponent & 1)
+                result = multiplyModulo(result, base, modulus, degree);
+            base = multiplyModulo(base, base, modulus, degree);
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    //A polynomial of degree d is primitive iff x has order 2^d-1 modulo it
+    bool isPrimitive(std::uint64_t polynomial, int degree)
+    {
+        if(degree == 1)
+            return true;
+        std::uint64_t order = (std::uint64_t(1) << degree) - 1;
+        if(powerModulo(order, polynomial, degree) != 1)
+            return false;
+        std::uint64_t remaining = order;
+        for(std::uint64_t factor = 2; remaining > 1; factor++)
+        {
+            //When no factor is left below its square root, what remains is prime
+            if(factor*factor > remaining)
+                factor = remaining;
+            if(remaining % factor == 0)
+            {
+                if(powerModulo(order/factor, polynomial, degree) == 1)
+                    return false;
+                while(remaining % factor == 0)
+                    remaining /= factor;
+            }
+        }
+        return true;
+    }
+}
+
+SobolSequence::SobolSequence(std::size_t dimension):
+    dimension_(dimension), directions_(32*dimension)
+{
+    //The first dimension is the van der Corput sequence
+    for(int k = 0; k < 32 && dimension_ > 0; k++)
+        directions_[k] = std::uint32_t(1) << (31-k);
+
+    //The primitive polynomials x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 are enumerated by increasing
+    //degree s and increasing a = (a_1...a_(s-1)) in base 2
+    int degree = 1;
+    std::uint64_t a = 0;
+    //Initial direction numbers of the dimensions beyond the tables are odd numbers drawn at random
+    RandomStream stream(0);
+    for(std::size_t d = 1; d < dimension_; d++)
+    {
+        std::uint64_t polynomial;
+        do
+        {
+            if(a >= (std::uint64_t(1) << (degree-1)))
+            {
+                degree++;
+                a = 0;
+            }
+            polynomial = (std::uint64_t(1) << degree) | (a << 1) | 1;
+            a++;
+        } while(!isPrimitive(polynomial, degree));
+        std::uint64_t coefficients = a-1;
+
+        std::vector<std::uint64_t> m(33);
+        for(int k = 1; k <= degree && k <= 32; k++)
+        {
+            if(d <= 20)
+                m[k] = joeKuoInitialNumbers[d-1][k-1];
+            else
+                m[k] = (std::uint64_t(stream.nextUniform()*(std::uint64_t(1) << (k-1))) << 1) | 1;
+        }
+        //Recurrence m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s)
+        for(int k = degree+1; k <= 32; k++)
+        {
+            m[k] = m[k-degree] ^ (m[k-degree] << degree);
+            for(int i = 1; i < degree; i++)
+            {
+                if(coefficients >> (degree-1-i) & 1)
+                    m[k] ^= m[k-i] << i;
+            }
+        }
+        for(int k = 1; k <= 32; k++)
+            directions_[32*d+k-1] = std::uint32_t(m[k] << (32-k));
+    }
+}
+
+std::size_t SobolSequence::getDimension() const
+{
+    return dimension_;
+}
+
+void SobolSequence::point(std::uint64_t pointIndex, std::uint32_t* coordinates) const
+{
+    //The point of index n is the XOR of the direction numbers selected by the bits of its Gray code
+    std::uint64_t grayCode = pointIndex ^ (pointIndex >> 1);
+    for(std::size_t d = 0; d < dimension_; d++)
+    {
+        std::uint32_t coordinate = 0;
+        for(int k = 0; k < 32; k++)
+        {
+            if(grayCode >> k & 1)
+                coordinate ^= directions_[32*d+k];
+        }
+        coordinates[d] = coordinate;
+    }
+}
+
+void SobolSequence::nextPoint(std::uint64_t pointIndex, std::uint32_t* coordinates) const
+{
+    //The Gray codes of n-1 and n differ by the bit of the lowest zero bit of n-1
+    int k = 0;
+    std::uint64_t previousIndex = pointIndex-1;
+    while(previousIndex >> k & 1)
+        k++;
+    for(std::size_t d = 0; d < dimension_; d++)
+        coordinates[d] ^= directions_[32*d+k];
+}
@@ -0,0 +1,28 @@
+#ifndef SOBOLSEQUENCE_H
+#define SOBOLSEQUENCE_H
+
+#include <cstdint>
+#include <vector>
+
+/*Sobol low-discrepancy sequence in base 2 with 32 bits of precision.
+The primitive polynomials are enumerated by increasing degree, as in Joe and Kuo's tables, whose
+initial direction numbers are used for the first dimensions. Any point can be computed directly
+from its index, so that blocks of points can be generated independently by several threads */
+class SobolSequence
+{
+private:
+    std::size_t dimension_;
+    //directions_[32*d+k] is the k-th direction number of the dimension d
+    std::vector<std::uint32_t> directions_;
+public:
+    SobolSequence(std::size_t dimension);
+    std::size_t getDimension() const;
+
+    //Fills coordinates with the integer coordinates of the point of index pointIndex
+    void point(std::uint64_t pointIndex, std::uint32_t* coordinates) const;
+    /*Updates in place the coordinates of the point of index pointIndex-1 into those of the point
+    of index pointIndex (Gray code ordering, one XOR per dimension) */
+    void nextPoint(std::uint64_t pointIndex, std::uint32_t* coordinates) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "TimeGrid.h"
+#include "MathFunctions.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+TimeGrid::TimeGrid(const std::vector<double>& dates, std::size_t nbTimePointsPerPeriod)
+{
+    timePoints_.push_back(dates.front());
+    observationIndexes_.push_back(0);
+    for(std::size_t j = 0; j < dates.size()-1; j++)
+        addPeriod(dates, j, MathFunctions::buildLinearSpace(dates[j], dates[j+1],
+                                                            std::max(nbTimePointsPerPeriod, std::size_t(2))));
+}
+
+TimeGrid::TimeGrid(const std::vector<double>& dates, std::size_t nbTimePointsPerPeriod,
+                   const HestonModel& hestonModel)
+{
+    double kappa = hestonModel.getMeanReversionSpeed();
+
+    //Clock of the period [start,end] and its speed, the limit kappa -> 0 being the uniform clock of speed 1 + refinement
+    auto clock = [kappa](double start, double end, double t)
+    {
+        if(kappa*(end-start) < 1e-8)
+            return (1. + refinement)*(t-start);
+        return (t-start) + refinement*(std::expm1(-kappa*(end-t)) - std::expm1(-kappa*(end-start)))/kappa;
+    };
+
+    /*Each period has one step, and the other ones are shared in proportion to the lengths of the periods on
+    their clocks, the steps left by the rounding going to the largest remainders */
+    std::size_t nbPeriods = dates.size()-1;
+    std::size_t nbSteps = std::max(nbTimePointsPerPeriod, std::size_t(2))-1;
+    std::size_t nbSharedSteps = (nbSteps-1)*nbPeriods;
+    std::vector<double> clockLengths(nbPeriods);
+    double clockLength = 0.;
+    for(std::size_t j = 0; j < nbPeriods; j++)
+    {
+        clockLengths[j] = clock(dates[j], dates[j+1], dates[j+1]);
+        clockLength += clockLengths[j];
+    }
+    std::vector<std::size_t> nbPeriodSteps(nbPeriods);
+    std::vector<std::pair<double, std::size_t>> remainders(nbPeriods);
+    std::size_t nbLeftSteps = nbSharedSteps;
+    for(std::size_t j = 0; j < nbPeriods; j++)
+    {
+        double share = nbSharedSteps*clockLengths[j]/clockLength;
+        nbPeriodSteps[j] = 1 + std::size_t(share);
+        nbLeftSteps -= std::size_t(share);
+        remainders[j] = std::make_pair(share - std::floor(share), j);
+    }
+    std::sort(remainders.begin(), remainders.end(), std::greater<std::pair<double, std::size_t>>());
+    for(std::size_t j = 0; j < nbLeftSteps && j < nbPeriods; j++)
+        nbPeriodSteps[remainders[j].second]++;
+
+    /*Inside a period, the points are equally spaced on the clock. Its inverse is computed by Newton's method,
+    which converges from any initial guess since the clock is increasing and convex */
+    timePoints_.push_back(dates.front());
+    observationIndexes_.push_back(0);
+    for(std::size_t j = 0; j < nbPeriods; j++)
+    {
+        double start = dates[j], end = dates[j+1];
+        std::vector<double> periodTimePoints(1, start);
+        for(std::size_t k = 1; k < nbPeriodSteps[j]; k++)
+        {
+            double clockPoint = clockLengths[j]*k/nbPeriodSteps[j];
+            periodTimePoints.push_back(MathFunctions::newtonMethod(periodTimePoints.back(),
+                                       [&](double t){return clock(start, end, t) - clockPoint;},
+                                       [&](double t){return 1. + refinement*std::exp(-kappa*(end-t));}, 1e-13));
+        }
+        periodTimePoints.push_back(end);
+        addPeriod(dates, j, periodTimePoints);
+    }
+}
+
+void TimeGrid::addPeriod(const std::vector<double>& dates, std::size_t j,
+                         const std::vector<double>& periodTimePoints)
+{
+    timePoints_.insert(timePoints_.end(), periodTimePoints.begin()+1, periodTimePoints.end()-1);
+    timePoints_.push_back(dates[j+1]);
+    observationIndexes_.push_back(timePoints_.size()-1);
+}
+
+std::vector<double> TimeGrid::getTimePoints() const
+{
+    return timePoints_;
+}
+
+std::vector<std::size_t> TimeGrid::getObservationIndexes() const
+{
+    return observationIndexes_;
+}
+
+std::vector<std::size_t> TimeGrid::observationIndexes(const std::vector<double>& timePoints,
+                                                      const std::vector<double>& dates)
+{
+    std::vector<std::size_t> indexes;
+    for(std::size_t i = 0; i < dates.size(); i++)
+    {
+        std::size_t idx = MathFunctions::binarySearch(timePoints, dates[i]);
+        indexes.push_back(dates[i]-timePoints[idx] <= timePoints[idx+1]-dates[i] ? idx : idx+1);
+    }
+    return indexes;
+}
@@ -0,0 +1,41 @@
+#ifndef TIMEGRID_H
+#define TIMEGRID_H
+
+#include <vector>
+#include "Model.h"
+
+/*Simulation grid of a variance swap : the observation dates are points of the grid, and the index of each of
+them in the grid is recorded, so that the steps between two dates don't need to be equal nor equally many.
+The adaptive grid spends a given budget of steps where the discretization bias of the squared returns comes
+from. The trapezoidal rule of the log-spot schemes integrates the covariance of V(s) with the variance at the end
+of the period, which bends like exp(-kappa (end-s)) : the steps of a period are equally spaced on the clock
+s(t) = t + refinement (exp(-kappa (end-t)) - exp(-kappa (end-start)))/kappa, hence finer towards the observation
+date, on the relaxation time 1/kappa. When kappa times the period is small, the clock is nearly uniform */
+class TimeGrid
+{
+private:
+    std::vector<double> timePoints_;
+    std::vector<std::size_t> observationIndexes_;
+
+    //Ratio of the speeds of the clock at the end and far from the end of a period, minus 1
+    static constexpr double refinement = 3.;
+
+    //Appends the points of the period [dates[j],dates[j+1]], the last one being dates[j+1] exactly
+    void addPeriod(const std::vector<double>& dates, std::size_t j, const std::vector<double>& periodTimePoints);
+public:
+    //Uniform grid : nbTimePointsPerPeriod equally spaced points on each period, both dates included
+    TimeGrid(const std::vector<double>& dates, std::size_t nbTimePointsPerPeriod);
+    /*Adaptive grid with as many steps as the uniform one, distributed between and inside the periods according
+    to the mean reversion speed of the model. Each period has at least one step */
+    TimeGrid(const std::vector<double>& dates, std::size_t nbTimePointsPerPeriod, const HestonModel& hestonModel);
+    ~TimeGrid() = default;
+
+    std::vector<double> getTimePoints() const;
+    std::vector<std::size_t> getObservationIndexes() const;
+
+    //Indexes of the points of timePoints closest to the dates, timePoints being sorted
+    static std::vector<std::size_t> observationIndexes(const std::vector<double>& timePoints,
+                                                       const std::vector<double>& dates);
+};
+
+#endif
@@ -1,6 +1,69 @@
-#include <complex>
 #include "VarianceSwapsHestonAnalyticalPricer.h"
 #include "MathFunctions.h"
+#include "Dual.h"
+
+namespace
+{
+    //Heston parameters with respect to which the sensitivities are computed, in this order
+    const std::size_t nbSensitivities = 5;
+    typedef Dual<nbSensitivities> ParameterDual;
+
+    /*Prices of variance swaps with the formulas of the pricer, for parameters of type T. The derivatives of
+    c and d of the periods are looked up in termsByLength, keyed on the length of the periods, and only
+    computed for the lengths which aren't in it yet.
+    The term of a period only depends on its dates, so that the terms of the longest schedule are
+    computed once and reused for the periods of the other schedules which start with the same dates,
+    as the schedules of a term structure of variance swaps do */
+    template<typename T>
+    std::vector<T> realPrices(const std::vector<std::vector<double>>& dateSets, double r, double mu,
+                              const T& kappa, const T& theta, const T& sigma, const T& rho, const T& v0,
+                              std::map<double, std::vector<T>>& termsByLength)
+    {
+        using std::exp;
+        auto periodTerm = [&](const std::vector<double>& dates, std::size_t i) -> T
+        {
+            typename std::map<double, std::vector<T>>::iterator it =
+                    VarianceSwapsHestonAnalyticalPricer::findPeriodTerms(termsByLength, dates[i]-dates[i-1],
+                                                                         [&](double delta)
+            {
+                std::vector<T> terms(4);
+                VarianceSwapsHestonAnalyticalPricer::periodDerivatives(delta, r, mu, kappa, theta, sigma, rho,
+                                                                       exp(-delta*kappa), terms.data());
+                return terms;
+            });
+            if(i == 1)
+                return VarianceSwapsHestonAnalyticalPricer::firstPeriodTerm(v0, it->second.data());
+            return VarianceSwapsHestonAnalyticalPricer::periodTerm(kappa, theta, sigma, v0,
+                                                                   exp(-dates[i-1]*kappa), it->second.data());
+        };
+
+        std::size_t longestIdx = 0;
+        for(std::size_t k = 1; k < dateSets.size(); k++)
+            if(dateSets[k].size() > dateSets[longestIdx].size())
+                longestIdx = k;
+        const std::vector<double>& longestDates = dateSets[longestIdx];
+        std::vector<T> longestTerms(longestDates.size());
+        for(std::size_t i = 1; i < longestDates.size(); i++)
+            longestTerms[i] = periodTerm(longestDates, i);
+
+        std::vector<T> prices;
+        for(std::size_t k = 0; k < dateSets.size(); k++)
+        {
+            const std::vector<double>& dates = dateSets[k];
+            T price = 0.;
+            bool sameDates = true;
+            for(std::size_t i = 1; i < dates.size(); i++)
+            {
+                double tolerance = VarianceSwapsHestonAnalyticalPricer::periodLengthTolerance*(dates[i]-dates[i-1]);
+                sameDates = sameDates && std::abs(dates[i-1]-longestDates[i-1]) <= tolerance
+                                      && std::abs(dates[i]-longestDates[i]) <= tolerance;
+                price = price + (sameDates ? longestTerms[i] : periodTerm(dates, i));
+            }
+            prices.push_back(price * (10000. / dates.back()));
+        }
+        return prices;
+    }
+}
 
 VarianceSwapsHestonAnalyticalPricer::VarianceSwapsHestonAnalyticalPricer(
                                             const HestonModel& hestonModel):
@@ -30,160 +93,58 @@ VarianceSwapsHestonAnalyticalPricer& VarianceSwapsHestonAnalyticalPricer::operat
 	{
 		delete hestonModel_;												
 		hestonModel_ = new HestonModel(*(analyticalPricer.hestonModel_));
+        //The cached terms belong to the previous model
+        std::lock_guard<std::mutex> lock(periodTermsCacheMutex_);
+        periodTermsCache_.clear();
 	}
 	return *this;
 }
 
-std::complex<double>j(0.,1.);
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-aTerm(double omega) const {
-    return hestonModel_->getMeanReversionSpeed() - hestonModel_->getCorrelation() * hestonModel_->getVolOfVol() * omega * j  ;
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-bTerm(double omega) const {
-    double sigma = hestonModel_->getVolOfVol();
-    std::complex<double> a = aTerm(omega);
-    return std::sqrt(a*a+ sigma*sigma * (j*omega + omega*omega) )  ;
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-gTerm(double omega) const {
-    std::complex<double> a = aTerm(omega),
-                    b = bTerm(omega);
-    return (a-b)/(a+b); //defintion during class -> more stable
-    // return (a+b)/(a-b); //definition in PDF
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionC(double tau, double omega) const {
-    double r = hestonModel_->getRiskFreeRate(),
-           mu = hestonModel_->getDrift(),
-           kappa = hestonModel_->getMeanReversionSpeed(),
-           theta = hestonModel_->getMeanReversionLevel(),
-           sigma = hestonModel_->getVolOfVol();
-    std::complex<double> a = aTerm(omega),
-                        b = bTerm(omega),
-                        g = gTerm(omega);
-    return tau*(j * omega*mu - r)+ kappa * theta / (sigma*sigma) * ((a-b)*tau-2.*std::log((1.-g*std::exp(-b*tau))/(1.-g))) ; // definition in class
-    // return tau * r * (j * omega - 1.)+ kappa * theta / (sigma*sigma) * ((a+b)*tau-2.*std::log((1.-g*std::exp(b*tau))/(1.-g))) ; // definition in PDF
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionD(double tau, double omega) const {
-    double sigma = hestonModel_->getVolOfVol();
-    std::complex<double> a = aTerm(omega), 
-                         b = bTerm(omega),
-                         g = gTerm(omega);
-    std::complex<double> D_init = (a-b)/(sigma*sigma); //definition during class
-    return D_init*(1.-std::exp(-b*tau))/(1.-g*std::exp(-b*tau)); // in class
-    // return D_init*(1.-std::exp(b*tau))/(1.-g*std::exp(b*tau)); // in PDF
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionDPrime(double tau, double omega) const {
-    std::function<std::complex<double>(double,double)> f = [=](double tau, double omega){
-        return this->functionD(tau,omega);
-    };
-    return MathFunctions::finiteDifference(f,omega,tau);
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionCPrime(double tau, double omega) const {
-    std::function<std::complex<double>(double,double)> f = [=](double tau, double omega){
-        return this->functionC(tau,omega);
-    };
-    return MathFunctions::finiteDifference(f,omega,tau);
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionCSecond(double tau, double omega) const {
-    std::function<std::complex<double>(double,double)> f = [=](double tau, double omega){
-        return this->functionCPrime(tau,omega);
-    };
-    return MathFunctions::finiteDifference(f,omega,tau);
-}
-
-std::complex<double> VarianceSwapsHestonAnalyticalPricer::
-functionDSecond(double tau, double omega) const {
-    std::function<std::complex<double>(double,double)> f = [=](double tau, double omega){
-        return this->functionDPrime(tau,omega);
-    };
-    return MathFunctions::finiteDifference(f,omega,tau);
-}
-
-double VarianceSwapsHestonAnalyticalPricer::
-qtildeTerm() const {
-    double kappa = hestonModel_->getMeanReversionSpeed(), 
-           theta = hestonModel_->getMeanReversionLevel(),
-           sigma = hestonModel_->getVolOfVol();
-    return (2*kappa*theta/(sigma*sigma));
-}
-
-double VarianceSwapsHestonAnalyticalPricer::
-cTerm(double t) const {
-    double kappa = hestonModel_->getMeanReversionSpeed(),
-           sigma = hestonModel_->getVolOfVol();
-    return 2 * kappa / (sigma*sigma*(1.-std::exp(-kappa*t)));
-}
-
-double VarianceSwapsHestonAnalyticalPricer::
-wTerm(double t) const {
-    return cTerm(t)*std::exp(-hestonModel_->getMeanReversionSpeed()*t)*hestonModel_->getInitialVolatility();
-}
-
-double VarianceSwapsHestonAnalyticalPricer::
-u1Term(double t1, double t2) const {
-    double delta = t2-t1,
-           v0 = hestonModel_->getInitialVolatility();
-    std::complex<double> C1 = functionCPrime(delta,0.),
-                        C2 = functionCSecond(delta,0.),
-                        D1 = functionDPrime(delta,0.),
-                        D2 = functionDSecond(delta,0.);
-    std::complex<double> firstTerm = D1*D1*v0*v0,
-                        secondTerm = v0*(2.0*C1*D1-D2),
-                        thirdTerm = C1*C1 - C2;
-    std::complex<double> u1 = firstTerm+secondTerm+thirdTerm; 
-    return u1.real();
-}
-
-double VarianceSwapsHestonAnalyticalPricer::
-uiTerm(double t1, double t2) const {
-    double delta = t2-t1,
-           qtilde = qtildeTerm(),
-           Wi = wTerm(t1),
-           ci = cTerm(t1);
-    std::complex<double> C1 = functionCPrime(delta,0.),
-           C2 = functionCSecond(delta,0.),
-           D1 = functionDPrime(delta,0.),
-           D2 = functionDSecond(delta,0.);
-    std::complex<double> firstTerm = (qtilde+2*Wi+(qtilde + Wi)*(qtilde + Wi)) 
-                                        *D1*D1/(ci*ci),
-                        secondTerm = (qtilde+Wi)*(2.0*C1*D1 - D2) / ci,
-                        thirdTerm= C1*C1 - C2;
-    std::complex<double> ui = firstTerm+secondTerm+thirdTerm;
-    return ui.real();
-}
-
 double VarianceSwapsHestonAnalyticalPricer::price(const VarianceSwap& varianceSwap) const{
-    double price=0;
-    std::vector<double> dates = varianceSwap.getDates();
-
-    price = price + u1Term(dates[0],dates[1]);
-    for (std::size_t i = 2; i < dates.size(); i++)
-    {   
-        // std::cout << uiTerm(dates[i-1],dates[i]) << std::endl;
-        price = price + uiTerm(dates[i-1],dates[i]);
+    //The derivatives of c and d of the periods are kept from one call to the next
+    std::lock_guard<std::mutex> lock(periodTermsCacheMutex_);
+    return realPrices<double>({varianceSwap.getDates()}, hestonModel_->getRiskFreeRate(), hestonModel_->getDrift(),
+                              hestonModel_->getMeanReversionSpeed(), hestonModel_->getMeanReversionLevel(),
+                              hestonModel_->getVolOfVol(), hestonModel_->getCorrelation(),
+                              hestonModel_->getInitialVolatility(), periodTermsCache_).front();
+}
+
+VarianceSwapSensitivities VarianceSwapsHestonAnalyticalPricer::sensitivities(const VarianceSwap& varianceSwap) const{
+    return sensitivities(std::vector<VarianceSwap>{varianceSwap}).front();
+}
+
+std::vector<VarianceSwapSensitivities> VarianceSwapsHestonAnalyticalPricer::sensitivities(
+                                            const std::vector<VarianceSwap>& varianceSwaps) const{
+    ParameterDual kappa = ParameterDual::variable(hestonModel_->getMeanReversionSpeed(), 0),
+                  theta = ParameterDual::variable(hestonModel_->getMeanReversionLevel(), 1),
+                  sigma = ParameterDual::variable(hestonModel_->getVolOfVol(), 2),
+                  rho = ParameterDual::variable(hestonModel_->getCorrelation(), 3),
+                  v0 = ParameterDual::variable(hestonModel_->getInitialVolatility(), 4);
+    std::vector<std::vector<double>> dateSets;
+    for(std::size_t k = 0; k < varianceSwaps.size(); k++)
+        dateSets.push_back(varianceSwaps[k].getDates());
+    std::map<double, std::vector<ParameterDual>> termsByLength;
+    std::vector<ParameterDual> prices = realPrices(dateSets, hestonModel_->getRiskFreeRate(),
+                                                   hestonModel_->getDrift(), kappa, theta, sigma, rho, v0,
+                                                   termsByLength);
+
+    std::vector<VarianceSwapSensitivities> sensitivities(prices.size());
+    for(std::size_t k = 0; k < prices.size(); k++)
+    {
+        sensitivities[k].price = prices[k].value;
+        sensitivities[k].meanReversionSpeed = prices[k].derivatives[0];
+        sensitivities[k].meanReversionLevel = prices[k].derivatives[1];
+        sensitivities[k].volOfVol = prices[k].derivatives[2];
+        sensitivities[k].correlation = prices[k].derivatives[3];
+        sensitivities[k].initialVolatility = prices[k].derivatives[4];
     }
-    price = price * 10000. / dates.back();
-    return price;
+    return sensitivities;
 }
 
 double VarianceSwapsHestonAnalyticalPricer::continousPrice(const VarianceSwap &varianceSwap) {
     double price=0;
     std::vector<double> dates = varianceSwap.getDates();
     double maturity=dates.back();
-    price = 10000. * hestonModel_->getMeanReversionLevel() + (hestonModel_->getInitialVolatility()-hestonModel_->getMeanReversionLevel())*(1.-exp(-maturity*hestonModel_->getMeanReversionSpeed()))/(maturity*hestonModel_->getMeanReversionSpeed());
+    price = 10000. * (hestonModel_->getMeanReversionLevel() + (hestonModel_->getInitialVolatility()-hestonModel_->getMeanReversionLevel())*(1.-exp(-maturity*hestonModel_->getMeanReversionSpeed()))/(maturity*hestonModel_->getMeanReversionSpeed()));
     return price;
 }
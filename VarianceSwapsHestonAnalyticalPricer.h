@@ -2,34 +2,32 @@
 #define VARIANCESWAPSHESTONANALYTICALPRICER_H
 
 #include "VarianceSwapsPricer.h"
-#include <complex>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Jet.h"
+
+//Price of a variance swap and its derivatives with respect to the parameters of the Heston model
+struct VarianceSwapSensitivities
+{
+    double price;
+    double meanReversionSpeed;
+    double meanReversionLevel;
+    double volOfVol;
+    double correlation;
+    double initialVolatility;
+};
 
 class VarianceSwapsHestonAnalyticalPricer : public VarianceSwapsHestonPricer
 {
 private:
     HestonModel* hestonModel_;
 
-    //useful variables to compute function C and D
-    std::complex<double> aTerm (double omega) const ;
-    std::complex<double> bTerm (double omega) const ;
-    std::complex<double> gTerm (double omega) const ;
-
-    //functions C and D and their derivatives
-    std::complex<double> functionC (double tau, double omega) const;
-    std::complex<double> functionD (double tau, double omega) const;
-    std::complex<double> functionDPrime (double tau, double omega) const;
-    std::complex<double> functionCPrime (double tau, double omega) const;
-    std::complex<double> functionDSecond (double tau, double omega) const;
-    std::complex<double> functionCSecond (double tau, double omega) const;
-
-    //useful terms with respect to the Chi2 law
-    double qtildeTerm () const;
-    double cTerm (double t) const;
-    double wTerm (double t) const;
-
-    //E[log²(Sti/Sti-1)]
-    double u1Term (double t1, double t2) const; //Case i = 1
-    double uiTerm (double t1, double t2) const; //Case i > 1
+    /*Cache of the derivatives of c and d of the periods, keyed on their length as in findPeriodTerms (the model of
+    the pricer being fixed). The cache is protected by a mutex so that price can be called concurrently on the same
+    pricer */
+    mutable std::map<double, std::vector<double>> periodTermsCache_;
+    mutable std::mutex periodTermsCacheMutex_;
 public:
     VarianceSwapsHestonAnalyticalPricer(const HestonModel& hestonModel);
 
@@ -42,8 +40,103 @@ public:
     //Method returning the analytical price of the variance swap given as argument
     double price(const VarianceSwap& varianceSwap) const override;
 
+    /*Method returning the analytical price of the variance swap with its sensitivities to kappa, theta,
+    eps, rho and V0, all computed in one evaluation of the price by automatic differentiation */
+    VarianceSwapSensitivities sensitivities(const VarianceSwap& varianceSwap) const;
+    /*Same for several variance swaps, typically a term structure, in one evaluation : the periods
+    shared by the schedules of the variance swaps are only computed once */
+    std::vector<VarianceSwapSensitivities> sensitivities(const std::vector<VarianceSwap>& varianceSwaps) const;
+
     //Method returning the analytical price in the continuous case
     double continousPrice(const VarianceSwap& varianceSwap);
+
+    /*Formulas of the price for parameters of type T (double, or Dual for the sensitivities), also used by the batch
+    pricer. Only the derivatives of C and D at omega = 0 are needed : with the substitution omega = -iu,
+    c(u) = C(-iu) and d(u) = D(-iu) are real around u = 0, and C'(0) = i c'(0), C''(0) = -c''(0) (same for D).
+    periodDerivatives fills derivatives with c'(0), c''(0), d'(0) and d''(0) for a period of length delta. At
+    u = 0, a = b = kappa and g = 0, so that exp(-kappa delta), given by the caller, is the only transcendental term */
+    template<typename T>
+    static void periodDerivatives(double delta, double r, double mu, const T& kappa, const T& theta,
+                                  const T& sigma, const T& rho, const T& expKappaDelta, T* derivatives);
+    /*E[log²(Sti/Sti-1)] given the derivatives of the period. Given the variance V at ti-1, it is the second moment
+    c''(0) + d''(0) V + (c'(0) + d'(0) V)², the last term being the squared conditional mean of the log-return.
+    The variance at the start of the first period is V0, at the start ti-1 of the next ones it is c/2 times a
+    noncentral chi-square variable, expKappaStart being exp(-kappa ti-1) */
+    template<typename T>
+    static T firstPeriodTerm(const T& v0, const T* derivatives);
+    template<typename T>
+    static T periodTerm(const T& kappa, const T& theta, const T& sigma, const T& v0, const T& expKappaStart,
+                        const T* derivatives);
+
+    //Relative tolerance under which two lengths of periods, or two dates, are considered equal
+    static constexpr double periodLengthTolerance = 1e-12;
+    /*Entry of termsByLength for a period of length delta, computeTerms(delta) being inserted if there is none.
+    Two lengths within the tolerance share the same entry, since equidistant dates give lengths which only differ
+    by rounding errors. The scalar and batch pricers both look up their terms by it */
+    template<typename Terms, typename ComputeTerms>
+    static typename std::map<double, Terms>::iterator findPeriodTerms(std::map<double, Terms>& termsByLength,
+                                                                      double delta, ComputeTerms computeTerms);
 };
 
+template<typename T>
+void VarianceSwapsHestonAnalyticalPricer::periodDerivatives(double delta, double r, double mu, const T& kappa,
+                                                            const T& theta, const T& sigma, const T& rho,
+                                                            const T& expKappaDelta, T* derivatives)
+{
+    typedef Jet<T> RealJet;
+    T sigma2 = sigma*sigma;
+    RealJet u = RealJet::variable(T(0.));
+    RealJet a = kappa - rho*sigma*u;
+    //Square root of b² at kappa²
+    RealJet b = compose(a*a + sigma2*(u - u*u), kappa, T(0.5)/kappa, T(-0.25)/(kappa*kappa*kappa));
+    RealJet g = (a-b)/(a+b);
+    //Exponential of -delta b at -delta kappa
+    RealJet expTerm = compose(-delta*b, expKappaDelta, expKappaDelta, expKappaDelta);
+    //Logarithm of (1-g exp(-b delta))/(1-g) at 1
+    RealJet logTerm = compose((1.-g*expTerm)/(1.-g), T(0.), T(1.), T(-1.));
+
+    RealJet C = delta*(mu*u - r) + kappa*theta/sigma2*((a-b)*delta - 2.*logTerm);
+    RealJet D = (a-b)/sigma2*(1.-expTerm)/(1.-g*expTerm);
+    derivatives[0] = C.firstDerivative;
+    derivatives[1] = C.secondDerivative;
+    derivatives[2] = D.firstDerivative;
+    derivatives[3] = D.secondDerivative;
+}
+
+template<typename T>
+T VarianceSwapsHestonAnalyticalPricer::firstPeriodTerm(const T& v0, const T* derivatives)
+{
+    const T& c1 = derivatives[0];
+    const T& c2 = derivatives[1];
+    const T& d1 = derivatives[2];
+    const T& d2 = derivatives[3];
+    return d1*d1*v0*v0 + v0*(d2 + 2.*c1*d1) + c1*c1 + c2;
+}
+
+template<typename T>
+T VarianceSwapsHestonAnalyticalPricer::periodTerm(const T& kappa, const T& theta, const T& sigma, const T& v0,
+                                                  const T& expKappaStart, const T* derivatives)
+{
+    const T& c1 = derivatives[0];
+    const T& c2 = derivatives[1];
+    const T& d1 = derivatives[2];
+    const T& d2 = derivatives[3];
+    T sigma2 = sigma*sigma,
+      qtilde = 2.*kappa*theta/sigma2,
+      ci = 2.*kappa/(sigma2*(1.-expKappaStart)),
+      Wi = ci*expKappaStart*v0;
+    return (qtilde + 2.*Wi + (qtilde + Wi)*(qtilde + Wi))*d1*d1/(ci*ci)
+           + (qtilde + Wi)*(d2 + 2.*c1*d1)/ci + c1*c1 + c2;
+}
+
+template<typename Terms, typename ComputeTerms>
+typename std::map<double, Terms>::iterator VarianceSwapsHestonAnalyticalPricer::findPeriodTerms(
+                                    std::map<double, Terms>& termsByLength, double delta, ComputeTerms computeTerms)
+{
+    typename std::map<double, Terms>::iterator it = termsByLength.lower_bound(delta*(1.-periodLengthTolerance));
+    if(it == termsByLength.end() || it->first > delta*(1.+periodLengthTolerance))
+        it = termsByLength.insert(it, std::make_pair(delta, computeTerms(delta)));
+    return it;
+}
+
 #endif
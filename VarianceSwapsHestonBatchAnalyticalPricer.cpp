@@ -0,0 +1,124 @@
+#include <map>
+#include "VarianceSwapsHestonBatchAnalyticalPricer.h"
+#include "MathFunctions.h"
+#include "VarianceSwapsHestonAnalyticalPricer.h"
+
+namespace
+{
+    /*Derivatives at u = 0 of c and d for a period of length delta, model by model. The pointers are
+    restricted so that the compiler vectorizes the loop without runtime aliasing checks */
+    void periodTermsKernel(std::size_t nbModels, double delta,
+                           const double* __restrict r, const double* __restrict mu,
+                           const double* __restrict kappa, const double* __restrict theta,
+                           const double* __restrict sigma, const double* __restrict rho,
+                           const double* __restrict expValues,
+                           double* __restrict cPrime, double* __restrict cSecond,
+                           double* __restrict dPrime, double* __restrict dSecond)
+    {
+        for(std::size_t i = 0; i < nbModels; i++)
+        {
+            //The parameters are copied so that the references taken by the formulas don't alias the outputs
+            double kappaI = kappa[i], thetaI = theta[i], sigmaI = sigma[i], rhoI = rho[i], expValue = expValues[i];
+            double derivatives[4];
+            VarianceSwapsHestonAnalyticalPricer::periodDerivatives(delta, r[i], mu[i], kappaI, thetaI, sigmaI,
+                                                                   rhoI, expValue, derivatives);
+            cPrime[i] = derivatives[0];
+            cSecond[i] = derivatives[1];
+            dPrime[i] = derivatives[2];
+            dSecond[i] = derivatives[3];
+        }
+    }
+}
+
+VarianceSwapsHestonBatchAnalyticalPricer::VarianceSwapsHestonBatchAnalyticalPricer(
+                                            const HestonModelBatch& hestonModels):
+        hestonModels_(hestonModels)
+{
+
+}
+
+VarianceSwapsHestonBatchAnalyticalPricer::PeriodTerms
+VarianceSwapsHestonBatchAnalyticalPricer::periodTerms(double delta) const
+{
+    std::size_t nbModels = hestonModels_.size();
+    const double* r = hestonModels_.getRiskFreeRates().data();
+    const double* mu = hestonModels_.getDrifts().data();
+    const double* kappa = hestonModels_.getMeanReversionSpeeds().data();
+    const double* theta = hestonModels_.getMeanReversionLevels().data();
+    const double* sigma = hestonModels_.getVolOfVols().data();
+    const double* rho = hestonModels_.getCorrelations().data();
+
+    //exp(-b tau) is the only transcendental term : at u = 0, a = b = kappa and g = 0
+    std::vector<double> expTerms(nbModels);
+    for(std::size_t i = 0; i < nbModels; i++)
+        expTerms[i] = -kappa[i]*delta;
+    MathFunctions::exponential(expTerms.data(), expTerms.data(), nbModels);
+
+    PeriodTerms terms;
+    terms.cPrime.resize(nbModels);
+    terms.cSecond.resize(nbModels);
+    terms.dPrime.resize(nbModels);
+    terms.dSecond.resize(nbModels);
+    periodTermsKernel(nbModels, delta, r, mu, kappa, theta, sigma, rho, expTerms.data(),
+                      terms.cPrime.data(), terms.cSecond.data(), terms.dPrime.data(), terms.dSecond.data());
+    return terms;
+}
+
+std::vector<double> VarianceSwapsHestonBatchAnalyticalPricer::prices(const VarianceSwap& varianceSwap) const
+{
+    std::size_t nbModels = hestonModels_.size();
+    const double* kappa = hestonModels_.getMeanReversionSpeeds().data();
+    const double* theta = hestonModels_.getMeanReversionLevels().data();
+    const double* sigma = hestonModels_.getVolOfVols().data();
+    const double* v0 = hestonModels_.getInitialVolatilities().data();
+    std::vector<double> dates = varianceSwap.getDates();
+
+    //The terms depending on the length of the periods are only computed once per distinct length
+    std::map<double, PeriodTerms> periodTermsByLength;
+    std::vector<const PeriodTerms*> terms;
+    for(std::size_t i = 1; i < dates.size(); i++)
+    {
+        std::map<double, PeriodTerms>::iterator it = VarianceSwapsHestonAnalyticalPricer::findPeriodTerms(
+                periodTermsByLength, dates[i]-dates[i-1], [this](double delta) { return periodTerms(delta); });
+        terms.push_back(&it->second);
+    }
+
+    //E[log²(St1/St0)]
+    std::vector<double> prices(nbModels);
+    {
+        const double* c1 = terms[0]->cPrime.data();
+        const double* c2 = terms[0]->cSecond.data();
+        const double* d1 = terms[0]->dPrime.data();
+        const double* d2 = terms[0]->dSecond.data();
+        for(std::size_t i = 0; i < nbModels; i++)
+        {
+            double derivatives[4] = {c1[i], c2[i], d1[i], d2[i]};
+            prices[i] = VarianceSwapsHestonAnalyticalPricer::firstPeriodTerm(v0[i], derivatives);
+        }
+    }
+
+    //E[log²(Sti/Sti-1)] for i > 1, which depends on the law of V at ti-1
+    std::vector<double> expTerms(nbModels);
+    for(std::size_t period = 2; period < dates.size(); period++)
+    {
+        double t = dates[period-1];
+        for(std::size_t i = 0; i < nbModels; i++)
+            expTerms[i] = -kappa[i]*t;
+        MathFunctions::exponential(expTerms.data(), expTerms.data(), nbModels);
+
+        const double* c1 = terms[period-1]->cPrime.data();
+        const double* c2 = terms[period-1]->cSecond.data();
+        const double* d1 = terms[period-1]->dPrime.data();
+        const double* d2 = terms[period-1]->dSecond.data();
+        for(std::size_t i = 0; i < nbModels; i++)
+        {
+            double derivatives[4] = {c1[i], c2[i], d1[i], d2[i]};
+            prices[i] += VarianceSwapsHestonAnalyticalPricer::periodTerm(kappa[i], theta[i], sigma[i], v0[i],
+                                                                         expTerms[i], derivatives);
+        }
+    }
+
+    for(std::size_t i = 0; i < nbModels; i++)
+        prices[i] *= 10000./dates.back();
+    return prices;
+}
@@ -0,0 +1,29 @@
+#ifndef VARIANCESWAPSHESTONBATCHANALYTICALPRICER_H
+#define VARIANCESWAPSHESTONBATCHANALYTICALPRICER_H
+
+#include <vector>
+#include "VarianceSwap.h"
+#include "Model.h"
+
+/*Analytical pricer of a variance swap under a batch of Heston models, with the formulas of
+VarianceSwapsHestonAnalyticalPricer. They are applied model by model in loops over the structure of arrays of
+parameters that the compiler vectorizes, the exponentials being computed beforehand by a batch function */
+class VarianceSwapsHestonBatchAnalyticalPricer
+{
+private:
+    HestonModelBatch hestonModels_;
+
+    //Derivatives at u = 0 of c and d for a period of length delta, for each model of the batch
+    struct PeriodTerms
+    {
+        std::vector<double> cPrime, cSecond, dPrime, dSecond;
+    };
+    PeriodTerms periodTerms(double delta) const;
+public:
+    VarianceSwapsHestonBatchAnalyticalPricer(const HestonModelBatch& hestonModels);
+
+    //Method returning the analytical prices of the variance swap given as argument, one per model
+    std::vector<double> prices(const VarianceSwap& varianceSwap) const;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "VarianceSwapsHestonCalibrator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    //Calibrated parameters : kappa, theta, eps, rho and V0
+    const std::size_t nbParameters = 5;
+    const std::size_t volOfVolIdx = 2;
+    const std::size_t correlationIdx = 3;
+    //Bound keeping the correlation in the domain of the model
+    const double maxAbsoluteCorrelation = 0.999;
+    //Damping of the Levenberg-Marquardt steps : initial value, factor of its updates and maximal value
+    const double initialDamping = 1e-3;
+    const double dampingFactor = 10.;
+    const double maxDamping = 1e12;
+    /*Maximal change of a coordinate in one step : the parameters are at most multiplied or divided by
+    exp(maxStep), so that a step can't jump to the plateaus where the prices don't depend on a parameter
+    anymore, like kappa going to infinity */
+    const double maxStep = 1.;
+
+    std::vector<double> modelParameters(const HestonModel& hestonModel)
+    {
+        return {hestonModel.getMeanReversionSpeed(), hestonModel.getMeanReversionLevel(),
+                hestonModel.getVolOfVol(), hestonModel.getCorrelation(), hestonModel.getInitialVolatility()};
+    }
+
+    HestonModel buildModel(const HestonModel& hestonModel, const std::vector<double>& parameters)
+    {
+        return HestonModel(hestonModel.getRiskFreeRate(), hestonModel.getDrift(), parameters[0], parameters[1],
+                           parameters[2], parameters[3], parameters[4], hestonModel.getInitialAssetValue());
+    }
+
+    /*The Levenberg-Marquardt steps are taken on the logarithms of the positive parameters, which keeps them
+    positive and makes the steps relative to their values, and on the correlation itself, which is clamped */
+    std::vector<double> toParameters(const std::vector<double>& coordinates)
+    {
+        std::vector<double> parameters(nbParameters);
+        for(std::size_t j = 0; j < nbParameters; j++)
+            parameters[j] = j == correlationIdx
+                    ? std::min(std::max(coordinates[j], -maxAbsoluteCorrelation), maxAbsoluteCorrelation)
+                    : std::exp(coordinates[j]);
+        return parameters;
+    }
+
+    std::vector<double> toCoordinates(const std::vector<double>& parameters)
+    {
+        std::vector<double> coordinates(nbParameters);
+        for(std::size_t j = 0; j < nbParameters; j++)
+            coordinates[j] = j == correlationIdx
+                    ? std::min(std::max(parameters[j], -maxAbsoluteCorrelation), maxAbsoluteCorrelation)
+                    : std::log(parameters[j]);
+        return coordinates;
+    }
+
+    /*Solution of the symmetric positive definite system matrix*x = rhs of size nbParameters by Gaussian
+    elimination. Returns false if the matrix is numerically singular */
+    bool solveLinearSystem(std::vector<double> matrix, std::vector<double> rhs, std::vector<double>& x)
+    {
+        std::size_t n = rhs.size();
+        for(std::size_t k = 0; k < n; k++)
+        {
+            if(!(matrix[k*n+k] > 0.))
+                return false;
+            for(std::size_t i = k+1; i < n; i++)
+            {
+                double factor = matrix[i*n+k]/matrix[k*n+k];
+                for(std::size_t j = k; j < n; j++)
+                    matrix[i*n+j] -= factor*matrix[k*n+j];
+                rhs[i] -= factor*rhs[k];
+            }
+        }
+        x.assign(n, 0.);
+        for(std::size_t k = n; k-- > 0;)
+        {
+            double sum = rhs[k];
+            for(std::size_t j = k+1; j < n; j++)
+                sum -= matrix[k*n+j]*x[j];
+            x[k] = sum/matrix[k*n+k];
+        }
+        return true;
+    }
+}
+
+VarianceSwapsHestonCalibrator::VarianceSwapsHestonCalibrator(const std::vector<VarianceSwap>& varianceSwaps,
+                                                             const std::vector<double>& fairStrikes,
+                                                             bool calibrateVolOfVolAndCorrelation,
+                                                             std::size_t maxNbIterations,
+                                                             double tolerance):
+        varianceSwaps_(varianceSwaps),
+        fairStrikes_(fairStrikes),
+        calibrateVolOfVolAndCorrelation_(calibrateVolOfVolAndCorrelation),
+        maxNbIterations_(maxNbIterations),
+        tolerance_(tolerance)
+{
+
+}
+
+double VarianceSwapsHestonCalibrator::residuals(const HestonModel& hestonModel, std::vector<double>& residuals,
+                                                std::vector<double>& jacobian) const
+{
+    VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+    std::vector<VarianceSwapSensitivities> sensitivities = anPricer.sensitivities(varianceSwaps_);
+    residuals.resize(varianceSwaps_.size());
+    jacobian.resize(varianceSwaps_.size()*nbParameters);
+    double squaredResiduals = 0.;
+    for(std::size_t k = 0; k < varianceSwaps_.size(); k++)
+    {
+        residuals[k] = sensitivities[k].price - fairStrikes_[k];
+        squaredResiduals += residuals[k]*residuals[k];
+        jacobian[k*nbParameters] = sensitivities[k].meanReversionSpeed;
+        jacobian[k*nbParameters+1] = sensitivities[k].meanReversionLevel;
+        jacobian[k*nbParameters+2] = sensitivities[k].volOfVol;
+        jacobian[k*nbParameters+3] = sensitivities[k].correlation;
+        jacobian[k*nbParameters+4] = sensitivities[k].initialVolatility;
+    }
+    return squaredResiduals;
+}
+
+CalibrationResult VarianceSwapsHestonCalibrator::calibrate(const HestonModel& initialModel) const
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> coordinates = toCoordinates(modelParameters(initialModel));
+    std::vector<double> parameters = toParameters(coordinates);
+    std::vector<double> currentResiduals, jacobian;
+    double squaredResiduals = residuals(buildModel(initialModel, parameters), currentResiduals, jacobian);
+
+    double damping = initialDamping;
+    bool converged = false;
+    std::size_t iteration = 0;
+    while(iteration < maxNbIterations_ && !converged)
+    {
+        iteration++;
+        /*Normal equations of the linearized problem : (J^T J) step = -J^T residuals, J being the jacobian
+        with respect to the coordinates, i.e. d price/d log(p) = p d price/dp for the positive parameters */
+        std::vector<double> normalMatrix(nbParameters*nbParameters, 0.);
+        std::vector<double> gradient(nbParameters, 0.);
+        for(std::size_t k = 0; k < currentResiduals.size(); k++)
+        {
+            double row[nbParameters];
+            for(std::size_t j = 0; j < nbParameters; j++)
+                row[j] = jacobian[k*nbParameters+j]*(j == correlationIdx ? 1. : parameters[j]);
+            for(std::size_t i = 0; i < nbParameters; i++)
+            {
+                gradient[i] -= row[i]*currentResiduals[k];
+                for(std::size_t j = 0; j < nbParameters; j++)
+                    normalMatrix[i*nbParameters+j] += row[i]*row[j];
+            }
+        }
+        //The equations of the fixed parameters are replaced by step = 0
+        for(std::size_t i = 0; i < nbParameters && !calibrateVolOfVolAndCorrelation_; i++)
+        {
+            if(i != volOfVolIdx && i != correlationIdx)
+                continue;
+            for(std::size_t j = 0; j < nbParameters; j++)
+                normalMatrix[i*nbParameters+j] = normalMatrix[j*nbParameters+i] = 0.;
+            normalMatrix[i*nbParameters+i] = 1.;
+            gradient[i] = 0.;
+        }
+
+        /*The diagonal is scaled by 1+damping (Marquardt), so that the steps don't depend on the scales of the
+        parameters. The damping is increased until the step decreases the squared residuals */
+        bool improved = false;
+        while(!improved && damping < maxDamping)
+        {
+            std::vector<double> dampedMatrix = normalMatrix;
+            for(std::size_t i = 0; i < nbParameters; i++)
+                dampedMatrix[i*nbParameters+i] += damping*std::max(normalMatrix[i*nbParameters+i],
+                                                                   std::numeric_limits<double>::min());
+            std::vector<double> step;
+            if(!solveLinearSystem(dampedMatrix, gradient, step))
+            {
+                damping *= dampingFactor;
+                continue;
+            }
+
+            double stepLength = 0.;
+            for(std::size_t j = 0; j < nbParameters; j++)
+                stepLength = std::max(stepLength, std::abs(step[j]));
+            double stepScale = stepLength > maxStep ? maxStep/stepLength : 1.;
+            std::vector<double> newCoordinates = coordinates;
+            for(std::size_t j = 0; j < nbParameters; j++)
+                newCoordinates[j] += stepScale*step[j];
+            newCoordinates = toCoordinates(toParameters(newCoordinates));
+            std::vector<double> newParameters = toParameters(newCoordinates);
+            std::vector<double> newResiduals, newJacobian;
+            double newSquaredResiduals = residuals(buildModel(initialModel, newParameters), newResiduals, newJacobian);
+            if(newSquaredResiduals < squaredResiduals)
+            {
+                improved = true;
+                double change = 0.;
+                for(std::size_t j = 0; j < nbParameters; j++)
+                    change = std::max(change, std::abs(newCoordinates[j]-coordinates[j]));
+                converged = change < tolerance_
+                            || squaredResiduals-newSquaredResiduals < tolerance_*squaredResiduals;
+                coordinates = newCoordinates;
+                parameters = newParameters;
+                currentResiduals = newResiduals;
+                jacobian = newJacobian;
+                squaredResiduals = newSquaredResiduals;
+                damping = std::max(damping/dampingFactor, std::numeric_limits<double>::epsilon());
+            }
+            else
+                damping *= dampingFactor;
+        }
+        //No step decreases the squared residuals anymore : the parameters are a local minimum
+        if(!improved)
+            converged = true;
+    }
+
+    double computationTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return {buildModel(initialModel, parameters), std::sqrt(squaredResiduals/currentResiduals.size()),
+            iteration, converged, computationTime};
+}
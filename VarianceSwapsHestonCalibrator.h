@@ -0,0 +1,60 @@
+#ifndef VARIANCESWAPSHESTONCALIBRATOR_H
+#define VARIANCESWAPSHESTONCALIBRATOR_H
+
+#include "VarianceSwapsHestonAnalyticalPricer.h"
+#include <vector>
+
+//Heston model fitted to a term structure of variance swaps
+struct CalibrationResult
+{
+    /*Calibrated model : kappa, theta, eps, rho and V0 are fitted, the risk-free rate, the drift and the
+    initial asset value being those of the initial model */
+    HestonModel model;
+    //Root mean squared difference between the model prices and the fair strikes
+    double rootMeanSquaredError;
+    std::size_t nbIterations;
+    //False if the maximal number of iterations was reached before the convergence criteria
+    bool converged;
+    //Wall-clock time spent (in seconds)
+    double computationTime;
+};
+
+/*Least-squares calibration of the Heston parameters to the fair strikes of variance swaps, with the
+Levenberg-Marquardt algorithm. The prices of all the variance swaps and their exact gradients are given
+by one evaluation of the analytical pricer per iteration.
+NB : the fair strikes of variance swaps determine kappa, theta and V0 through the expected variance
+theta + (V0-theta)exp(-kappa t). eps and rho only change them through the discrete monitoring and are
+hardly identifiable, so that by default they are kept to their values in the initial model, typically
+given by a calibration to vanilla options */
+class VarianceSwapsHestonCalibrator
+{
+private:
+    std::vector<VarianceSwap> varianceSwaps_;
+    //Market fair strikes of the variance swaps, in the unit of the prices of the pricers
+    std::vector<double> fairStrikes_;
+    /*If false, eps and rho are not calibrated. If true, the calibration should start from a model close to
+    the solution, e.g. the previous calibrated model, since the fit is then nearly flat along eps and rho */
+    bool calibrateVolOfVolAndCorrelation_;
+    std::size_t maxNbIterations_;
+    /*The calibration stops when an iteration changes the parameters, or decreases the squared residuals,
+    by less than tolerance_ relatively */
+    double tolerance_;
+
+    /*Method filling residuals with the differences between the model prices and the fair strikes, and
+    jacobian with their derivatives, stored as jacobian[k*5+j] for the variance swap k and the parameter j
+    (kappa, theta, eps, rho and V0 in this order). It returns the sum of the squared residuals */
+    double residuals(const HestonModel& hestonModel, std::vector<double>& residuals,
+                     std::vector<double>& jacobian) const;
+public:
+    VarianceSwapsHestonCalibrator(const std::vector<VarianceSwap>& varianceSwaps,
+                                  const std::vector<double>& fairStrikes,
+                                  bool calibrateVolOfVolAndCorrelation = false,
+                                  std::size_t maxNbIterations = 100,
+                                  double tolerance = 1e-10);
+    /*Method calibrating the model starting from initialModel. When the market moves little between two
+    calibrations, the previous calibrated model is a good initial model (warm start) and the
+    calibration converges in a few iterations */
+    CalibrationResult calibrate(const HestonModel& initialModel) const;
+};
+
+#endif
@@ -1,11 +1,37 @@
 #include "VarianceSwapsHestonMonteCarloPricer.h"
+#include "MathFunctions.h"
+#include "Instrumentation.h"
+#include "TimeGrid.h"
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <limits>
+#include <chrono>
+#include <mutex>
+
+namespace
+{
+    //The standard error is not trusted to stop a simulation before this number of paths
+    const std::size_t minNbSimulationsBeforeStopping = 1000;
+    //Quantile of the standard normal distribution at 97.5%
+    const double confidenceQuantile = 1.959963984540054;
+}
 
 VarianceSwapsHestonMonteCarloPricer::VarianceSwapsHestonMonteCarloPricer
                                 (const HestonLogSpotPathSimulator& hestonPathSimulator,
-                                std::size_t nbSimulations):
+                                std::size_t nbSimulations,
+                                std::size_t nbThreads,
+                                std::size_t blockSize,
+                                SamplingMethod samplingMethod,
+                                std::size_t nbReplicates,
+                                bool useControlVariate):
             hestonPathSimulator_(hestonPathSimulator.clone()),
-            nbSimulations_(nbSimulations)
+            nbSimulations_(nbSimulations),
+            nbThreads_(nbThreads == 0 ? 1 : nbThreads),
+            blockSize_(blockSize == 0 ? 1 : blockSize),
+            samplingMethod_(samplingMethod),
+            nbReplicates_(nbReplicates == 0 ? 1 : nbReplicates),
+            useControlVariate_(useControlVariate)
 {
 
 }
@@ -18,7 +44,12 @@ VarianceSwapsHestonMonteCarloPricer::~VarianceSwapsHestonMonteCarloPricer()
 VarianceSwapsHestonMonteCarloPricer::VarianceSwapsHestonMonteCarloPricer(
                     const VarianceSwapsHestonMonteCarloPricer& mcPricer):
         hestonPathSimulator_(mcPricer.hestonPathSimulator_->clone()),
-        nbSimulations_(mcPricer.nbSimulations_)
+        nbSimulations_(mcPricer.nbSimulations_),
+        nbThreads_(mcPricer.nbThreads_),
+        blockSize_(mcPricer.blockSize_),
+        samplingMethod_(mcPricer.samplingMethod_),
+        nbReplicates_(mcPricer.nbReplicates_),
+        useControlVariate_(mcPricer.useControlVariate_)
 {
 
 }
@@ -32,50 +63,402 @@ VarianceSwapsHestonMonteCarloPricer& VarianceSwapsHestonMonteCarloPricer::operat
 	{
 		delete hestonPathSimulator_;												
 		hestonPathSimulator_ = mcPricer.hestonPathSimulator_->clone();
+        nbSimulations_ = mcPricer.nbSimulations_;
+        nbThreads_ = mcPricer.nbThreads_;
+        blockSize_ = mcPricer.blockSize_;
+        samplingMethod_ = mcPricer.samplingMethod_;
+        nbReplicates_ = mcPricer.nbReplicates_;
+        useControlVariate_ = mcPricer.useControlVariate_;
 	}
 	return *this;
 }
 
-double VarianceSwapsHestonMonteCarloPricer::pathPrice(std::vector<double> path,
+void VarianceSwapsHestonMonteCarloPricer::PathPriceStatistics::add(double price, double control)
+{
+    count++;
+    double delta = price - mean;
+    mean += delta/count;
+    squaredDeviations += delta*(price - mean);
+    double controlDelta = control - controlMean;
+    controlMean += controlDelta/count;
+    controlSquaredDeviations += controlDelta*(control - controlMean);
+    crossDeviations += delta*(control - controlMean);
+}
+
+void VarianceSwapsHestonMonteCarloPricer::PathPriceStatistics::merge(const PathPriceStatistics& statistics)
+{
+    if(statistics.count == 0)
+        return;
+    std::size_t totalCount = count + statistics.count;
+    double weight = double(count)*statistics.count/totalCount;
+    double delta = statistics.mean - mean;
+    double controlDelta = statistics.controlMean - controlMean;
+    mean += delta*statistics.count/totalCount;
+    controlMean += controlDelta*statistics.count/totalCount;
+    squaredDeviations += statistics.squaredDeviations + delta*delta*weight;
+    controlSquaredDeviations += statistics.controlSquaredDeviations + controlDelta*controlDelta*weight;
+    crossDeviations += statistics.crossDeviations + delta*controlDelta*weight;
+    count = totalCount;
+}
+
+double VarianceSwapsHestonMonteCarloPricer::pathPrice(double sumOfSquaredLogReturns,
                                                 double maturity) const
 {
-    double pathPrice = 0.0; 
-    for(size_t i = 0; i < path.size()-1; i++)
-    {   
-        pathPrice += std::pow(path[i+1]-path[i],2); //Reminder : path[i] = log(S_ti) 
+    //Reminder : the log-returns are computed from log(S_ti)
+    return 100*100*sumOfSquaredLogReturns/maturity;
+}
+
+void VarianceSwapsHestonMonteCarloPricer::addPathPrices(
+                                const std::vector<const HestonLogSpotPathSimulator*>& scenarioSimulators,
+                                RandomVariablesGenerator& randomVariablesGenerator,
+                                const std::vector<std::size_t>& indexes, double maturity,
+                                const std::vector<std::vector<double>>& outputWeights,
+                                std::vector<PathPriceStatistics>& statistics) const
+{
+    //In antithetic sampling, the path p and its mirror nbSamples+p are averaged into one sample
+    bool antithetic = samplingMethod_ == SamplingMethod::Antithetic;
+    std::size_t nbPaths = randomVariablesGenerator.getNbPaths();
+    std::size_t nbSamples = antithetic ? nbPaths/2 : nbPaths;
+    std::size_t nbScenarios = scenarioSimulators.size();
+
+    //Prices and control variates of the samples, stored as prices[scenarioIdx*nbSamples+p]
+    std::vector<double> prices(nbScenarios*nbSamples);
+    std::vector<double> controls(nbScenarios*nbSamples, 0.);
+    for(std::size_t scenarioIdx = 0; scenarioIdx < nbScenarios; scenarioIdx++)
+    {
+        /*The first scenarios are driven by copies of the generator, taken before it draws anything,
+        and the last one by the generator itself, so that they all get the same random variables */
+        RandomVariablesGenerator* generator = scenarioIdx+1 < nbScenarios ? randomVariablesGenerator.clone()
+                                                                           : &randomVariablesGenerator;
+        std::vector<double> integratedVariances;
+        std::vector<double> sumsOfSquaredLogReturns = scenarioSimulators[scenarioIdx]->sumOfSquaredLogReturns(
+                                                            *generator, indexes,
+                                                            useControlVariate_ ? &integratedVariances : nullptr);
+        if(generator != &randomVariablesGenerator)
+            delete generator;
+
+        INSTRUMENT_STAGE(Payoff, nbPaths);
+        for(size_t p = 0; p < nbSamples; p++)
+        {
+            double price = pathPrice(sumsOfSquaredLogReturns[p], maturity);
+            if(antithetic)
+                price = 0.5*(price + pathPrice(sumsOfSquaredLogReturns[nbSamples+p], maturity));
+            prices[scenarioIdx*nbSamples+p] = price;
+            if(useControlVariate_)
+            {
+                //The integrated variance is scaled like the realized variance
+                double control = pathPrice(integratedVariances[p], maturity);
+                if(antithetic)
+                    control = 0.5*(control + pathPrice(integratedVariances[nbSamples+p], maturity));
+                controls[scenarioIdx*nbSamples+p] = control;
+            }
+        }
     }
-    return 100*100*pathPrice/maturity;
+
+    //The paths were counted with the prices of the scenarios
+    INSTRUMENT_STAGE(Payoff, 0);
+    for(size_t p = 0; p < nbSamples; p++)
+    {
+        for(std::size_t outputIdx = 0; outputIdx < outputWeights.size(); outputIdx++)
+        {
+            double price = 0.;
+            double control = 0.;
+            for(std::size_t scenarioIdx = 0; scenarioIdx < nbScenarios; scenarioIdx++)
+            {
+                price += outputWeights[outputIdx][scenarioIdx]*prices[scenarioIdx*nbSamples+p];
+                control += outputWeights[outputIdx][scenarioIdx]*controls[scenarioIdx*nbSamples+p];
+            }
+            statistics[outputIdx].add(price, control);
+        }
+    }
+}
+
+double VarianceSwapsHestonMonteCarloPricer::expectedControlVariate(const HestonModel& hestonModel,
+                                const std::vector<std::size_t>& indexes, double maturity) const
+{
+    double kappa = hestonModel.getMeanReversionSpeed();
+    double theta = hestonModel.getMeanReversionLevel();
+    double V0 = hestonModel.getInitialVolatility();
+    std::vector<double> timePoints = hestonPathSimulator_->getTimePoints();
+
+    double integral = 0.;
+    for(std::size_t i = indexes.front(); i < indexes.back(); i++)
+    {
+        double currentMean = theta + (V0-theta)*std::exp(-kappa*timePoints[i]);
+        double nextMean = theta + (V0-theta)*std::exp(-kappa*timePoints[i+1]);
+        integral += 0.5*(timePoints[i+1]-timePoints[i])*(currentMean+nextMean);
+    }
+    return pathPrice(integral, maturity);
 }
 
 double VarianceSwapsHestonMonteCarloPricer::price(const VarianceSwap& varianceSwap) const
 {
-    double price = 0.;
+    return estimate(varianceSwap).price;
+}
+
+MonteCarloEstimate VarianceSwapsHestonMonteCarloPricer::estimate(const VarianceSwap& varianceSwap) const
+{
+    return simulate(varianceSwap, {hestonPathSimulator_}, {{1.}},
+                    0., std::numeric_limits<double>::infinity()).front();
+}
+
+MonteCarloEstimate VarianceSwapsHestonMonteCarloPricer::estimateToRelativeError(
+                                const VarianceSwap& varianceSwap, double targetRelativeError) const
+{
+    return simulate(varianceSwap, {hestonPathSimulator_}, {{1.}},
+                    targetRelativeError, std::numeric_limits<double>::infinity()).front();
+}
+
+MonteCarloEstimate VarianceSwapsHestonMonteCarloPricer::estimateWithinTimeBudget(
+                                const VarianceSwap& varianceSwap, double timeBudget) const
+{
+    return simulate(varianceSwap, {hestonPathSimulator_}, {{1.}}, 0., timeBudget).front();
+}
+
+MonteCarloSensitivities VarianceSwapsHestonMonteCarloPricer::sensitivities(const VarianceSwap& varianceSwap,
+                                                                           double relativeBump) const
+{
+    HestonModel hestonModel = hestonPathSimulator_->getHestonModel();
+    double r = hestonModel.getRiskFreeRate();
+    double mu = hestonModel.getDrift();
+    double S0 = hestonModel.getInitialAssetValue();
+    //Parameters kappa, theta, eps, rho and V0, in the order of the fields of MonteCarloSensitivities
+    std::vector<double> parameters {hestonModel.getMeanReversionSpeed(), hestonModel.getMeanReversionLevel(),
+                                    hestonModel.getVolOfVol(), hestonModel.getCorrelation(),
+                                    hestonModel.getInitialVolatility()};
+    const std::size_t correlationIdx = 3;
+
+    /*The scenario 0 is the model itself, the scenarios 2k+1 and 2k+2 the models whose parameter k is
+    bumped up and down. The output 0 is the price and the output k+1 the central difference of the
+    parameter k */
+    std::size_t nbParameters = parameters.size();
+    std::vector<const HestonLogSpotPathSimulator*> scenarioSimulators {hestonPathSimulator_};
+    std::vector<std::vector<double>> outputWeights(nbParameters+1, std::vector<double>(2*nbParameters+1, 0.));
+    outputWeights[0][0] = 1.;
+    for(std::size_t parameterIdx = 0; parameterIdx < nbParameters; parameterIdx++)
+    {
+        double bump = parameterIdx == correlationIdx || parameters[parameterIdx] == 0. ? relativeBump
+                                                    : relativeBump*std::abs(parameters[parameterIdx]);
+        for(double sign : {1., -1.})
+        {
+            std::vector<double> bumpedParameters = parameters;
+            bumpedParameters[parameterIdx] += sign*bump;
+            HestonModel bumpedModel(r, mu, bumpedParameters[0], bumpedParameters[1], bumpedParameters[2],
+                                    bumpedParameters[3], bumpedParameters[4], S0);
+            scenarioSimulators.push_back(hestonPathSimulator_->cloneWithModel(bumpedModel));
+        }
+        outputWeights[parameterIdx+1][2*parameterIdx+1] = 1./(2.*bump);
+        outputWeights[parameterIdx+1][2*parameterIdx+2] = -1./(2.*bump);
+    }
+
+    std::vector<MonteCarloEstimate> estimates = simulate(varianceSwap, scenarioSimulators, outputWeights,
+                                                         0., std::numeric_limits<double>::infinity());
+    for(std::size_t scenarioIdx = 1; scenarioIdx < scenarioSimulators.size(); scenarioIdx++)
+        delete scenarioSimulators[scenarioIdx];
+
+    MonteCarloSensitivities sensitivities;
+    sensitivities.price = estimates[0];
+    sensitivities.meanReversionSpeed = estimates[1];
+    sensitivities.meanReversionLevel = estimates[2];
+    sensitivities.volOfVol = estimates[3];
+    sensitivities.correlation = estimates[4];
+    sensitivities.initialVolatility = estimates[5];
+    return sensitivities;
+}
+
+std::vector<MonteCarloEstimate> VarianceSwapsHestonMonteCarloPricer::simulate(
+                                const VarianceSwap& varianceSwap,
+                                const std::vector<const HestonLogSpotPathSimulator*>& scenarioSimulators,
+                                const std::vector<std::vector<double>>& outputWeights,
+                                double targetRelativeError, double timeBudget) const
+{
+    auto start = std::chrono::steady_clock::now();
     std::vector<double> dates = varianceSwap.getDates();
     std::vector<double> simulationTimeSteps = hestonPathSimulator_->getTimePoints();
 
-    //We look for the indexes of the simulated path corresponding to the dates 
-    //of the variance swaps
-    std::vector<double> indexes;
-    std::size_t nbSimulationsBetweenDates = (simulationTimeSteps.size()+dates.size()-2)/(dates.size()-1);
-    for(size_t i = 0; i < dates.size(); i++)
+    //We look for the indexes of the simulated path corresponding to the dates of the variance swap, the steps
+    //between two dates being possibly unequal and unequally many
+    std::vector<std::size_t> indexes = TimeGrid::observationIndexes(simulationTimeSteps, dates);
+    double maturity = dates.back();
+
+    /*In antithetic sampling, the samples of the estimator are the pairs of paths. In pseudo-random
+    and antithetic sampling, all the samples form a single replicate */
+    bool quasiRandom = samplingMethod_ == SamplingMethod::QuasiRandom;
+    bool antithetic = samplingMethod_ == SamplingMethod::Antithetic;
+    std::size_t nbSamples = std::max(antithetic ? nbSimulations_/2 : nbSimulations_, std::size_t(1));
+    std::size_t nbSamplesPerBlock = antithetic ? std::max(blockSize_/2, std::size_t(1)) : blockSize_;
+    std::size_t nbReplicates = quasiRandom ? std::min(nbReplicates_, nbSamples) : 1;
+    std::size_t nbSamplesPerReplicate = nbSamples/nbReplicates;
+    std::size_t nbBlocksPerReplicate = (nbSamplesPerReplicate+nbSamplesPerBlock-1)/nbSamplesPerBlock;
+
+    //The Sobol sequence and the Brownian bridge are shared by all the blocks
+    std::size_t nbSteps = simulationTimeSteps.size()-1;
+    SobolSequence sobolSequence(quasiRandom ? QuasiRandomVariablesGenerator::nbQuasiRandomDimensions(nbSteps) : 0);
+    BrownianBridge bridge(quasiRandom ? simulationTimeSteps : std::vector<double>{0., 1.});
+    //The control variate of an output is the combination of those of the scenarios
+    std::size_t nbScenarios = scenarioSimulators.size();
+    std::size_t nbOutputs = outputWeights.size();
+    std::vector<double> expectedControls(nbOutputs, 0.);
+    for(std::size_t scenarioIdx = 0; scenarioIdx < nbScenarios && useControlVariate_; scenarioIdx++)
     {
-        indexes.push_back((nbSimulationsBetweenDates-1)*i);
+        double expectedControl = expectedControlVariate(scenarioSimulators[scenarioIdx]->getHestonModel(),
+                                                        indexes, maturity);
+        for(std::size_t outputIdx = 0; outputIdx < nbOutputs; outputIdx++)
+            expectedControls[outputIdx] += outputWeights[outputIdx][scenarioIdx]*expectedControl;
     }
-    double maturity = dates.back();
-    std::vector<double> simulatedPath;
-    std::vector<double> pathForPricing;
-	for (size_t simulationIdx = 0; simulationIdx < nbSimulations_; ++simulationIdx)
-	{
-		simulatedPath = hestonPathSimulator_->path();
-        //"Slicing" of the path in order to keep only the logspot at the dates
-        //of the variance swaps
-        for(size_t i = 0; i < indexes.size(); i++)
+
+    /*The round r is made of the block r of each replicate, so that the replicates keep the same size.
+    Without stopping rule, all the rounds are simulated at once. Otherwise, the stopping rules are
+    checked after each chunk of rounds, a chunk giving at least one block to each thread */
+    bool stoppingRule = targetRelativeError > 0. || timeBudget < std::numeric_limits<double>::infinity();
+    std::size_t nbRoundsPerChunk = stoppingRule ? (nbThreads_+nbReplicates-1)/nbReplicates : nbBlocksPerReplicate;
+
+    //The simulators are cloned for each worker thread so that no state is shared between threads
+    std::vector<std::vector<const HestonLogSpotPathSimulator*>> threadPathSimulators(1, scenarioSimulators);
+    for(std::size_t threadIdx = 1; threadIdx < nbThreads_; threadIdx++)
+    {
+        threadPathSimulators.push_back(std::vector<const HestonLogSpotPathSimulator*>());
+        for(std::size_t scenarioIdx = 0; scenarioIdx < nbScenarios; scenarioIdx++)
+            threadPathSimulators.back().push_back(scenarioSimulators[scenarioIdx]->clone());
+    }
+
+    //Statistics of the outputs, stored as replicateStatistics[replicateIdx][outputIdx]
+    std::vector<std::vector<PathPriceStatistics>> replicateStatistics(nbReplicates,
+                                                                      std::vector<PathPriceStatistics>(nbOutputs));
+    auto computeEstimate = [&](std::size_t outputIdx)
+    {
+        double expectedControl = expectedControls[outputIdx];
+        PathPriceStatistics statistics;
+        for(std::size_t replicateIdx = 0; replicateIdx < nbReplicates; replicateIdx++)
+            statistics.merge(replicateStatistics[replicateIdx][outputIdx]);
+        std::size_t n = statistics.count;
+
+        /*With a control variate, the estimator is mean - beta*(controlMean - E[control]). The beta
+        minimizing its variance is Cov(price, control)/Var(control), that we estimate from all the samples */
+        double variance = statistics.squaredDeviations/(n-1);
+        double beta = 0.;
+        if(useControlVariate_ && statistics.controlSquaredDeviations > 0.)
         {
-            pathForPricing.push_back(simulatedPath[indexes[i]]);
+            beta = statistics.crossDeviations/statistics.controlSquaredDeviations;
+            variance -= beta*statistics.crossDeviations/(n-1);
         }
-		price += pathPrice(pathForPricing, maturity);
-        pathForPricing.clear();
-	}
-	price /= nbSimulations_;
-	return price;
-}
\ No newline at end of file
+
+        MonteCarloEstimate estimate;
+        estimate.price = statistics.mean - beta*(statistics.controlMean - expectedControl);
+        if(quasiRandom)
+        {
+            //The replicates are independent and identically distributed
+            double replicatesVariance = 0.;
+            for(std::size_t replicateIdx = 0; replicateIdx < nbReplicates; replicateIdx++)
+            {
+                const PathPriceStatistics& replicate = replicateStatistics[replicateIdx][outputIdx];
+                double replicatePrice = replicate.mean - beta*(replicate.controlMean - expectedControl);
+                replicatesVariance += std::pow(replicatePrice-estimate.price, 2);
+            }
+            estimate.standardError = nbReplicates > 1 ? std::sqrt(replicatesVariance/(nbReplicates*(nbReplicates-1)))
+                                                      : std::numeric_limits<double>::quiet_NaN();
+        }
+        else
+        {
+            estimate.standardError = n > 1 ? std::sqrt(std::max(variance, 0.)/n)
+                                           : std::numeric_limits<double>::quiet_NaN();
+        }
+        estimate.lowerBound = estimate.price - confidenceQuantile*estimate.standardError;
+        estimate.upperBound = estimate.price + confidenceQuantile*estimate.standardError;
+        estimate.nbSimulations = antithetic ? 2*n : n;
+        return estimate;
+    };
+
+    //Counters and timers of the threads, merged when they have simulated their blocks (if instrumented)
+    Instrumentation::Report runReport = Instrumentation::Report();
+    std::vector<bool> threadReported(nbThreads_, false);
+    std::mutex runReportMutex;
+
+    std::vector<MonteCarloEstimate> estimates(nbOutputs);
+    for(std::size_t firstRound = 0; firstRound < nbBlocksPerReplicate; firstRound += nbRoundsPerChunk)
+    {
+        std::size_t nbBlocks = std::min(nbRoundsPerChunk, nbBlocksPerReplicate-firstRound)*nbReplicates;
+        std::vector<std::vector<PathPriceStatistics>> blockStatistics(nbBlocks,
+                                                                      std::vector<PathPriceStatistics>(nbOutputs));
+        auto simulateBlocks = [&](std::size_t firstBlock)
+        {
+            const std::vector<const HestonLogSpotPathSimulator*>& pathSimulators = threadPathSimulators[firstBlock];
+            Instrumentation::Report threadStart = Instrumentation::threadReport();
+            //The blocks are dealt to the threads in turn
+            for(std::size_t blockIdx = firstBlock; blockIdx < nbBlocks; blockIdx += nbThreads_)
+            {
+                std::size_t replicateIdx = blockIdx%nbReplicates;
+                std::size_t firstSample = (firstRound + blockIdx/nbReplicates)*nbSamplesPerBlock;
+                std::size_t nbBlockSamples = std::min(nbSamplesPerBlock, nbSamplesPerReplicate - firstSample);
+                if(quasiRandom)
+                {
+                    QuasiRandomVariablesGenerator generator(sobolSequence, bridge, MathFunctions::seed,
+                                                            replicateIdx, firstSample, nbBlockSamples);
+                    addPathPrices(pathSimulators, generator, indexes, maturity, outputWeights,
+                                  blockStatistics[blockIdx]);
+                }
+                else if(antithetic)
+                {
+                    AntitheticRandomVariablesGenerator generator(MathFunctions::seed, firstSample, nbBlockSamples);
+                    addPathPrices(pathSimulators, generator, indexes, maturity, outputWeights,
+                                  blockStatistics[blockIdx]);
+                }
+                else
+                {
+                    PseudoRandomVariablesGenerator generator(MathFunctions::seed, firstSample, nbBlockSamples);
+                    addPathPrices(pathSimulators, generator, indexes, maturity, outputWeights,
+                                  blockStatistics[blockIdx]);
+                }
+            }
+            if(Instrumentation::enabled())
+            {
+                Instrumentation::Report threadRun = Instrumentation::threadReport().since(threadStart);
+                std::lock_guard<std::mutex> lock(runReportMutex);
+                //A thread is counted once, although it simulates blocks in every chunk
+                threadRun.nbThreads = threadReported[firstBlock] ? 0 : 1;
+                threadReported[firstBlock] = true;
+                runReport.merge(threadRun);
+            }
+        };
+
+        if(nbThreads_ == 1)
+            simulateBlocks(0);
+        else
+        {
+            std::vector<std::thread> workers;
+            for(std::size_t threadIdx = 1; threadIdx < nbThreads_; threadIdx++)
+                workers.push_back(std::thread(simulateBlocks, threadIdx));
+            simulateBlocks(0);
+            for(std::size_t threadIdx = 0; threadIdx < workers.size(); threadIdx++)
+                workers[threadIdx].join();
+        }
+
+        /*The block statistics are merged in a fixed order so that the result is reproducible. The
+        relative error is checked after each round, the following rounds of the chunk being discarded,
+        so that the result of estimateToRelativeError doesn't depend on the number of threads either */
+        bool targetReached = false;
+        for(std::size_t roundIdx = 0; roundIdx < nbBlocks/nbReplicates && !targetReached; roundIdx++)
+        {
+            for(std::size_t replicateIdx = 0; replicateIdx < nbReplicates; replicateIdx++)
+                for(std::size_t outputIdx = 0; outputIdx < nbOutputs; outputIdx++)
+                    replicateStatistics[replicateIdx][outputIdx].merge(
+                                blockStatistics[roundIdx*nbReplicates+replicateIdx][outputIdx]);
+            for(std::size_t outputIdx = 0; outputIdx < nbOutputs; outputIdx++)
+                estimates[outputIdx] = computeEstimate(outputIdx);
+            targetReached = estimates[0].nbSimulations >= minNbSimulationsBeforeStopping
+                            && estimates[0].standardError <= targetRelativeError*std::abs(estimates[0].price);
+        }
+        double computationTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        for(std::size_t outputIdx = 0; outputIdx < nbOutputs; outputIdx++)
+            estimates[outputIdx].computationTime = computationTime;
+        if(targetReached || computationTime >= timeBudget)
+            break;
+    }
+
+    for(std::size_t threadIdx = 1; threadIdx < threadPathSimulators.size(); threadIdx++)
+        for(std::size_t scenarioIdx = 0; scenarioIdx < nbScenarios; scenarioIdx++)
+            delete threadPathSimulators[threadIdx][scenarioIdx];
+    runReport.computationTime = estimates[0].computationTime;
+    Instrumentation::setLastRunReport(runReport);
+    return estimates;
+}
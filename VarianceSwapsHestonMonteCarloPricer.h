@@ -3,23 +3,143 @@
 
 #include "VarianceSwapsPricer.h"
 #include "HestonLogSpotPathSimulator.h"
+#include "RandomVariablesGenerator.h"
+
+//Sampling of the random variables driving the simulated paths
+enum class SamplingMethod
+{
+    PseudoRandom, //Independent draws, one counter-based stream per path
+    QuasiRandom,  //Randomized Sobol points with a Brownian bridge ordering of the time steps
+    Antithetic    //Pairs of paths driven by mirrored pseudo-random variables, averaged into one sample
+};
+
+//Monte Carlo estimate of the price of a variance swap
+struct MonteCarloEstimate
+{
+    double price;
+    double standardError;
+    //Bounds of the asymptotic 95% confidence interval price +- 1.96*standardError
+    double lowerBound;
+    double upperBound;
+    //Number of paths simulated and wall-clock time spent (in seconds) to get the estimate
+    std::size_t nbSimulations;
+    double computationTime;
+};
+
+/*Monte Carlo estimates of the price of a variance swap and of its sensitivities to the parameters of
+the model. The field price of the estimate of a sensitivity holds the estimated derivative */
+struct MonteCarloSensitivities
+{
+    MonteCarloEstimate price;
+    MonteCarloEstimate meanReversionSpeed;
+    MonteCarloEstimate meanReversionLevel;
+    MonteCarloEstimate volOfVol;
+    MonteCarloEstimate correlation;
+    MonteCarloEstimate initialVolatility;
+};
 
 class VarianceSwapsHestonMonteCarloPricer : public VarianceSwapsHestonPricer
 {
 private:
     HestonLogSpotPathSimulator* hestonPathSimulator_;
     size_t nbSimulations_;
-    //Method computing the price of a variance swap for a given path of the underlying
-    double pathPrice(std::vector<double> path, double maturity) const;
+    //Number of worker threads the simulations are split across (1 means the calling thread)
+    size_t nbThreads_;
+    //Number of paths simulated together by the batched path engine
+    size_t blockSize_;
+    SamplingMethod samplingMethod_;
+    /*Number of independent randomizations of the Sobol points in quasi-random sampling, each of them
+    being used for nbSimulations_/nbReplicates_ paths. The dispersion of their prices gives the error */
+    size_t nbReplicates_;
+    /*If true, the integrated variance of each path, whose expectation is known in closed form, is
+    used as a control variate. Its coefficient is estimated from the simulated paths */
+    bool useControlVariate_;
+
+    /*Online statistics of a set of samples, updated with Welford's algorithm so that the variance
+    is not computed as the difference of two large sums */
+    struct PathPriceStatistics
+    {
+        std::size_t count = 0;
+        double mean = 0.;
+        //Sum of the squared deviations of the path prices from their mean
+        double squaredDeviations = 0.;
+        //Mean and squared deviations of the control variates, and sum of the products of the deviations
+        double controlMean = 0.;
+        double controlSquaredDeviations = 0.;
+        double crossDeviations = 0.;
+
+        void add(double price, double control);
+        //Adds the samples of statistics, which are disjoint from those of *this
+        void merge(const PathPriceStatistics& statistics);
+    };
+
+    /*Method computing the price of a variance swap for a given path of the underlying, from the sum
+    of the squared log-returns of the path between the dates of the variance swap */
+    double pathPrice(double sumOfSquaredLogReturns, double maturity) const;
+    /*Method adding the path prices of the paths driven by randomVariablesGenerator, and their control
+    variates if they are used, to statistics. The paths are never stored : the squared log-returns are
+    accumulated while they are simulated.
+    Each scenario simulator is driven by the same random variables, and the sample added to
+    statistics[o] is the combination of the scenario path prices with the weights outputWeights[o] */
+    void addPathPrices(const std::vector<const HestonLogSpotPathSimulator*>& scenarioSimulators,
+                       RandomVariablesGenerator& randomVariablesGenerator,
+                       const std::vector<std::size_t>& indexes, double maturity,
+                       const std::vector<std::vector<double>>& outputWeights,
+                       std::vector<PathPriceStatistics>& statistics) const;
+    /*Method returning the expectation of the control variate, i.e. of the trapezoidal integral of the
+    variance on the simulation grid between the observation indexes, scaled as a path price.
+    It is computed with the mean of the model E[V_t] = theta + (V0-theta)exp(-kappa t), which is also the mean of
+    the QE and noncentral chi-square schemes. The TG scheme doesn't match it exactly : its f_mu and f_sigma are
+    interpolated, and when psi is small the Gaussian is only truncated at 0, which raises the mean (up to 2.3% of
+    the mass is cut with confidenceMultiplier = 2). With TG, the adjusted price then carries the extra bias
+    beta (E[I] - E_TG[I]), of the order of the bias of the scheme on the mean of the variance */
+    double expectedControlVariate(const HestonModel& hestonModel, const std::vector<std::size_t>& indexes,
+                                  double maturity) const;
+    /*Method simulating at most nbSimulations_ paths of each scenario simulator with common random
+    numbers, by rounds made of the next block of each replicate, and returning the estimates of the
+    expectations of the combinations of the scenario prices given by outputWeights.
+    The simulation stops after the first round where the relative standard error of the first output
+    is below targetRelativeError, or where timeBudget seconds have elapsed since the beginning */
+    std::vector<MonteCarloEstimate> simulate(const VarianceSwap& varianceSwap,
+                                             const std::vector<const HestonLogSpotPathSimulator*>& scenarioSimulators,
+                                             const std::vector<std::vector<double>>& outputWeights,
+                                             double targetRelativeError, double timeBudget) const;
 public:
     VarianceSwapsHestonMonteCarloPricer(const HestonLogSpotPathSimulator& hestonPathSimulator,
-                                        std::size_t nbSimulations);
+                                        std::size_t nbSimulations,
+                                        std::size_t nbThreads = 1,
+                                        std::size_t blockSize = 256,
+                                        SamplingMethod samplingMethod = SamplingMethod::PseudoRandom,
+                                        std::size_t nbReplicates = 16,
+                                        bool useControlVariate = false);
     ~VarianceSwapsHestonMonteCarloPricer();
     VarianceSwapsHestonMonteCarloPricer(const VarianceSwapsHestonMonteCarloPricer& mcPricer);
     VarianceSwapsHestonMonteCarloPricer& operator=(
                         const VarianceSwapsHestonMonteCarloPricer& mcPricer);
     //Method returning the Monte Carlo price of the variance swap given as argument
     double price(const VarianceSwap& varianceSwap) const override;
+    /*Method returning the Monte Carlo price of the variance swap with its standard error.
+    NB : when several threads are used, each of them works on its own copy of the simulator.
+    The paths are simulated by blocks whose results are reduced in a fixed order, and each path
+    draws its random variables from streams determined by its index only, so that the estimate
+    only depends on the seed and on the block size, and not on the number of threads */
+    MonteCarloEstimate estimate(const VarianceSwap& varianceSwap) const;
+    /*Method simulating paths until the standard error of the estimate is below targetRelativeError
+    times its absolute value, nbSimulations_ being then the maximal number of paths. The stopping rule
+    is only applied once enough samples have been simulated for the standard error to be reliable */
+    MonteCarloEstimate estimateToRelativeError(const VarianceSwap& varianceSwap,
+                                               double targetRelativeError) const;
+    /*Method simulating paths until timeBudget seconds have elapsed, nbSimulations_ being then the
+    maximal number of paths, and returning the estimate given by the paths simulated so far.
+    NB : the deadline is checked between rounds of blocks, so that it can be exceeded by one round */
+    MonteCarloEstimate estimateWithinTimeBudget(const VarianceSwap& varianceSwap, double timeBudget) const;
+    /*Method returning the Monte Carlo price of the variance swap with its sensitivities to kappa, theta,
+    eps, rho and V0, each with its standard error, in one pass over the paths.
+    The sensitivities are central differences between models whose parameter is bumped by
+    relativeBump times its value (by relativeBump itself for rho), all the models being simulated with
+    the same random variables in the same path loop. The noise of the differences is then that of
+    the change of the path prices only, instead of that of two independent prices */
+    MonteCarloSensitivities sensitivities(const VarianceSwap& varianceSwap, double relativeBump = 1e-2) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,130 +2,89 @@
 #include <map>
 #include <string>
 #include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <thread>
 #include "HestonLogSpotPathSimulator.h"
 #include "HestonVariancePathSimulator.h"
 #include "VarianceSwap.h"
 #include "MathFunctions.h"
 #include "VarianceSwapsHestonMonteCarloPricer.h"
 #include "VarianceSwapsHestonAnalyticalPricer.h"
+#include "VarianceSwapsHestonBatchAnalyticalPricer.h"
+#include "VarianceSwapsHestonCalibrator.h"
+#include "ParameterSweep.h"
+#include "TimeGrid.h"
+#include "Instrumentation.h"
 
 //Root path where all the results will be written
 std::string rootPath = "../Tests/";
 
 void testKappaParameter(){
-    //Heston model parameters
-    double r = 0, drift = 0, theta = 0.04, eps = 1, rho = -0.9,
-            V0 = 0.04, X0 = 100;
-    double kappaInit = 0.2;
-
-    //Variance swap parameters
-    double maturity = 1.0;
-    size_t nbOfObservationsPerYear = 2;
-    double nbOfObservations = nbOfObservationsPerYear*maturity+1;
-
-    VarianceSwap varianceSwap(maturity,nbOfObservations);
+    //Heston model and variance swap parameters (the default ones), kappa being swept
+    SweepPoint basePoint;
+    basePoint.maturity = 1.0;
+    basePoint.nbOfObservationsPerYear = 2;
+
+    ParameterSweep sweep(basePoint);
+    std::vector<double> kappas;
+    for (size_t i=0 ; i<15 ; i=i+1)
+        kappas.push_back(0.2 + i * 0.05);
+    sweep.addAxis(SweepParameter::MeanReversionSpeed, kappas);
+
+    std::vector<SweepResult> results = sweep.run();
+    for(size_t i = 0; i < results.size(); i++)
+        std::cout << "Analytical price for kappa = " << results[i].point.meanReversionSpeed << " : "
+                  << results[i].analyticalPrice << std::endl;
 
     //We write our results in a csv file.
-    std::ofstream file;
-    file.open (rootPath+"test_kappa_influence.csv");
-    file << "Kappa;Prix Analytique \n";
-
-    //We loop over several values of kappa
-    for (size_t i=0 ; i<15 ; i=i+1){
-        double kappa = kappaInit + i * 0.05;
-        HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
-
-        std::cout << "Analytical computation of the price for kappa = " << kappa << std::endl;
-        VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
-        double analyticalPrice = anPricer.price(varianceSwap);
-        std::cout << analyticalPrice << std::endl << std::endl;
-
-        file << kappa << ";";
-        file << analyticalPrice << "\n";
-
-    }
-    file.close();
+    sweep.writeCsv(rootPath+"test_kappa_influence.csv", results);
 }
 
 void testMaturityParameter(){
-    //Heston model parameters
-    double r = 0, drift = 0, theta = 0.04, eps = 1, rho = -0.9,
-            V0 = 0.04, X0 = 100, kappa = 0.5 ;
-
-    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
-
-    //Variance swap parameters
-    double maturityInit = 0.5;
-    size_t nbOfObservationsPerYear = 2;
+    //Heston model and variance swap parameters (the default ones), the maturity being swept
+    SweepPoint basePoint;
+    basePoint.meanReversionSpeed = 0.5;
+    basePoint.nbOfObservationsPerYear = 2;
+
+    ParameterSweep sweep(basePoint);
+    std::vector<double> maturities;
+    for (size_t i=0 ; i<20 ; i=i+1)
+        maturities.push_back(0.5 + i * 0.5);
+    sweep.addAxis(SweepParameter::Maturity, maturities);
+
+    std::vector<SweepResult> results = sweep.run();
+    for(size_t i = 0; i < results.size(); i++)
+        std::cout << "Analytical price for maturity = " << results[i].point.maturity << " : "
+                  << results[i].analyticalPrice << std::endl;
 
     //We write our results in a csv file.
-    std::ofstream file;
-    file.open (rootPath+"test_maturity_influence.csv");
-    file << "Kappa;Prix Analytique \n";
-
-    //We loop over several maturities
-    for (size_t i=0 ; i<20 ; i=i+1){
-        double maturity = maturityInit + i * 0.5;
-        double nbOfObservations = nbOfObservationsPerYear*maturity+1;
-
-        VarianceSwap varianceSwap(maturity,nbOfObservations);
-
-        std::cout << "Analytical computation of the price for maturity = " << maturity << std::endl;
-        VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
-        double analyticalPrice = anPricer.price(varianceSwap);
-        std::cout << analyticalPrice << std::endl << std::endl;
-
-        file << maturity << ";";
-        file << analyticalPrice << "\n";
-
-    }
-    file.close();
+    sweep.writeCsv(rootPath+"test_maturity_influence.csv", results);
 }
 
 void testNbOfObservations()
 {
-    //Heston model parameters
-    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
-            V0 = 0.04, X0 = 100;
-
-    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
-
-    //Variance swap parameters
-    double maturity = 10.0;
-    double nbOfObservations;
-    double nbOfObservationsMax= 60;
+    //Heston model parameters (the default ones) and variance swap of maturity 10 years
+    SweepPoint basePoint;
+    basePoint.maturity = 10.0;
+
+    //We sweep the number of observations per year
+    ParameterSweep sweep(basePoint);
+    double nbOfObservationsPerYearMax = 60;
+    std::vector<double> nbOfObservationsPerYear;
+    for (size_t i=2 ; i<nbOfObservationsPerYearMax+1 ; i=i+20)
+        nbOfObservationsPerYear.push_back(i);
+    sweep.addAxis(SweepParameter::NbOfObservationsPerYear, nbOfObservationsPerYear);
+
+    std::vector<SweepResult> results = sweep.run();
+    for(size_t i = 0; i < results.size(); i++)
+        std::cout << results[i].point.nbOfObservationsPerYear << " observations per year : "
+                  << results[i].analyticalPrice << " (discrete), " << results[i].continuousAnalyticalPrice
+                  << " (continuous), difference " << results[i].analyticalPrice-results[i].continuousAnalyticalPrice
+                  << std::endl;
 
     //We write our results in a csv file.
-    std::ofstream file;
-    file.open(rootPath+"test_convergence_nb_of_observations_analytical.csv");
-    file << "Nombre d'observations;Prix Analytique;Prix Analytique Continu; Différence \n";
-
-    //We loop over several numbers of observations
-    for (size_t i=2 ; i<nbOfObservationsMax+1 ; i=i+20)
-    {
-        nbOfObservations= i*maturity+1;
-
-        VarianceSwap varianceSwap(maturity,nbOfObservations);
-
-        std::cout << "Analytical computation of the price for " << nbOfObservations << " observations" << std::endl;
-        VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
-        double analyticalPrice = anPricer.price(varianceSwap);
-        std::cout << analyticalPrice << std::endl << std::endl;
-
-        std::cout << "Analytical computation of the continous price " << std::endl;
-        double continuousAnalyticalPrice = anPricer.continousPrice(varianceSwap);
-        std::cout << continuousAnalyticalPrice << std::endl << std::endl;
-
-        std::cout << "Difference" << std::endl;
-        std::cout << analyticalPrice-continuousAnalyticalPrice << std::endl << std::endl;
-
-        file << nbOfObservations << ";";
-        file << analyticalPrice << ";";
-        file << continuousAnalyticalPrice << ";";
-        file << analyticalPrice-continuousAnalyticalPrice << "\n";
-
-    }
-    file.close();
+    sweep.writeCsv(rootPath+"test_convergence_nb_of_observations_analytical.csv", results);
 }
 
 void testNbOfSimulations()
@@ -155,14 +114,7 @@ void testNbOfSimulations()
     std::vector<double> dates = varianceSwap.getDates();
 
     //We create a time grid that includes the dates of observations of the variance swap
-    std::vector<double> timePoints, temp;
-    for(std::size_t j = 0; j < dates.size()-1; j++)
-    {
-        temp = MathFunctions::buildLinearSpace(dates[j],dates[j+1],nbTimePoints);
-        timePoints.insert(timePoints.end(), temp.begin(), temp.end()-1);
-        if(j == dates.size()-2)
-            timePoints.push_back(temp.back());
-    }
+    std::vector<double> timePoints = TimeGrid(dates,nbTimePoints).getTimePoints();
 
     TruncatedGaussianScheme truncatedGaussianScheme(timePoints,hestonModel);
     BroadieKayaScheme broadieKayaSchemeTG(truncatedGaussianScheme);
@@ -253,15 +205,8 @@ void testThreeParametersSets()
     size_t nbSimulations = 10000, nbTimePoints = 200;
     for(size_t i = 0; i < hestonModels.size(); i++)
     {
-        std::vector<double> timePoints, temp;
         dates = varianceSwaps[i].getDates();
-        for(std::size_t j = 0; j < dates.size()-1; j++)
-        {
-            temp = MathFunctions::buildLinearSpace(dates[j],dates[j+1],nbTimePoints);
-            timePoints.insert(timePoints.end(), temp.begin(), temp.end()-1);
-            if(j == dates.size()-2)
-                timePoints.push_back(temp.back());
-        }
+        std::vector<double> timePoints = TimeGrid(dates,nbTimePoints).getTimePoints();
 
         std::cout << "------------- Case " << i+1 << " -------------" << std::endl;
         std::cout << "Analytical computation of the price" << std::endl;
@@ -285,6 +230,29 @@ void testThreeParametersSets()
 }
 
 void testDiscretizationTimestep()
+{
+    //Heston model and variance swap parameters (the default ones)
+    SweepPoint basePoint;
+    basePoint.maturity = 1.0;
+    basePoint.nbOfObservationsPerYear = 2;
+    basePoint.nbSimulations = 10000;
+
+    //We sweep the number of points between two observation dates, for both variance schemes
+    ParameterSweep sweep(basePoint, {VarianceScheme::TruncatedGaussian, VarianceScheme::QuadraticExponential});
+    sweep.addAxis(SweepParameter::NbTimePointsPerPeriod, {100,1000,2000,3000,4000,5000,6000,7000,8000,9000,10000});
+
+    std::vector<SweepResult> results = sweep.run();
+    for(size_t i = 0; i < results.size(); i++)
+        std::cout << results[i].point.nbTimePointsPerPeriod << " points : " << results[i].analyticalPrice
+                  << " (analytical), " << results[i].monteCarloEstimates[0].price << " (TG + BroadieKaya), "
+                  << results[i].monteCarloEstimates[1].price << " (QE + BroadieKaya)" << std::endl;
+
+    /*We write our results in a csv file*/
+    sweep.writeCsv(rootPath+"test_convergence_timestep.csv", results);
+}
+
+
+void testMultiThreading()
 {
     //Heston model parameters
     double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
@@ -299,55 +267,890 @@ void testDiscretizationTimestep()
 
     VarianceSwap varianceSwap(maturity,nbOfObservations);
 
-    /*We write our results in a csv file*/
+    size_t nbSimulations = 100000;
+    size_t nbTimePoints = 1000;
+    std::vector<double> dates = varianceSwap.getDates();
+
+    //We create a time grid that includes the dates of observations of the variance swap
+    std::vector<double> timePoints = TimeGrid(dates,nbTimePoints).getTimePoints();
+
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_multithreading_scaling.csv");
+    file << "Nombre de threads;Temps (s);Speed-up;Prix BKQE \n";
+
+    //We loop over the number of threads, from 1 to the number of cores of the machine
+    size_t nbThreadsMax = std::max(1u, std::thread::hardware_concurrency());
+    double serialTime = 0.;
+    for(size_t nbThreads = 1; nbThreads < nbThreadsMax+1; nbThreads++)
+    {
+        std::cout << "---------- Nombre de threads : " << nbThreads << " ----------" << std::endl << std::endl;
+        VarianceSwapsHestonMonteCarloPricer mcPricerBKQE(broadieKayaSchemeQE,nbSimulations,nbThreads);
+
+        auto start = std::chrono::steady_clock::now();
+        double BKQEprice = mcPricerBKQE.price(varianceSwap);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if(nbThreads == 1)
+            serialTime = elapsed.count();
+
+        std::cout << BKQEprice << " computed in " << elapsed.count() << "s (speed-up : "
+                  << serialTime/elapsed.count() << ")" << std::endl << std::endl;
+
+        file << nbThreads << ";";
+        file << elapsed.count() << ";";
+        file << serialTime/elapsed.count() << ";";
+        file << BKQEprice << "\n";
+    }
+    file.close();
+}
+
+void testGaussianSamplers()
+{
+    //Number of Gaussian variables drawn by each sampler
+    size_t nbDraws = 10000000;
+    RandomStream stream(MathFunctions::seed);
+    std::vector<double> gaussians(nbDraws);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_gaussian_samplers.csv");
+    file << "Methode;Temps (s);Tirages par seconde;Moyenne;Variance \n";
+
+    for(size_t method = 0; method < 2; method++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if(method == 0)
+        {
+            for(size_t i = 0; i < nbDraws; i++)
+                gaussians[i] = MathFunctions::simulateGaussianRandomVariable(stream);
+        }
+        else
+            MathFunctions::simulateGaussianRandomVariables(gaussians.data(), nbDraws, stream);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double mean = 0., variance = 0.;
+        for(size_t i = 0; i < nbDraws; i++)
+        {
+            mean += gaussians[i];
+            variance += gaussians[i]*gaussians[i];
+        }
+        mean /= nbDraws;
+        variance = variance/nbDraws - mean*mean;
+
+        std::string name = method == 0 ? "Box-Muller" : "Ziggurat (batch)";
+        std::cout << name << " : " << nbDraws/elapsed.count() << " draws per second" << std::endl;
+        std::cout << "Mean : " << mean << ", variance : " << variance << std::endl << std::endl;
+
+        file << name << ";";
+        file << elapsed.count() << ";";
+        file << nbDraws/elapsed.count() << ";";
+        file << mean << ";";
+        file << variance << "\n";
+    }
+    file.close();
+}
+
+void testNormalCDFInverseBatch()
+{
+    //Number of uniforms mapped to Gaussian variables
+    size_t nbDraws = 10000000;
+    RandomStream stream(MathFunctions::seed);
+    std::vector<double> uniforms(nbDraws), scalarGaussians(nbDraws), batchGaussians(nbDraws);
+    MathFunctions::simulateUniformRandomVariables(uniforms.data(), nbDraws, stream);
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < nbDraws; i++)
+        scalarGaussians[i] = MathFunctions::normalCDFInverse(uniforms[i]);
+    std::chrono::duration<double> scalarTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    MathFunctions::normalCDFInverse(uniforms.data(), batchGaussians.data(), nbDraws);
+    std::chrono::duration<double> batchTime = std::chrono::steady_clock::now() - start;
+
+    //The batch version must give the same values as the scalar one, up to rounding errors
+    double maxError = 0.;
+    for(size_t i = 0; i < nbDraws; i++)
+        maxError = std::max(maxError, std::abs(batchGaussians[i]-scalarGaussians[i]));
+
+    std::cout << "Scalar inverse cdf : " << nbDraws/scalarTime.count() << " normals per second" << std::endl;
+    std::cout << "Batch inverse cdf : " << nbDraws/batchTime.count() << " normals per second" << std::endl;
+    std::cout << "Maximum difference : " << maxError << std::endl << std::endl;
+
+    //We write our results in a csv file.
     std::ofstream file;
-    file.open (rootPath+"test_convergence_timestep.csv");
-    //Pricing analytique
+    file.open (rootPath+"test_normal_cdf_inverse_batch.csv");
+    file << "Methode;Normales par seconde;Ecart maximal \n";
+    file << "Scalaire;" << nbDraws/scalarTime.count() << ";" << 0 << "\n";
+    file << "Batch;" << nbDraws/batchTime.count() << ";" << maxError << "\n";
+    file.close();
+}
+
+void testQuasiMonteCarlo()
+{
+    //Heston model parameters
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //Variance swap parameters
+    double maturity = 1.0;
+    size_t nbOfObservationsPerYear = 2;
+    size_t nbOfObservations = maturity*nbOfObservationsPerYear+1;
+
+    VarianceSwap varianceSwap(maturity,nbOfObservations);
+
     std::cout << "Analytical computation of the price" << std::endl;
     VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
     double analyticalPrice = anPricer.price(varianceSwap);
     std::cout << analyticalPrice << std::endl << std::endl;
 
-    //Pricing Monte-Carlo
-    file << "Nombre de points;Prix Analytique;Prix BKTG;Prix BKQE \n";
+    size_t nbTimePoints = 100;
     std::vector<double> dates = varianceSwap.getDates();
-    size_t nbSimulations = 10000;
-    std::vector<double> nbTimePoints{100,1000,2000,3000,4000,5000,6000,7000,8000,9000,10000};
-    
-    //We loop over the number of points between two observation dates
-    for(std::size_t i = 0; i < nbTimePoints.size(); i++)
+
+    //We create a time grid that includes the dates of observations of the variance swap
+    std::vector<double> timePoints = TimeGrid(dates,nbTimePoints).getTimePoints();
+
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_quasi_monte_carlo.csv");
+    file << "Nombre de simulations;Prix Analytique;Prix MC;Erreur MC;Prix QMC;Erreur QMC \n";
+
+    //We loop over numbers of simulations that are multiples of the 16 replicates times a power of 2
+    for(size_t nbSimulations = 16*64; nbSimulations <= 16*8192; nbSimulations *= 2)
     {
-        file << nbTimePoints[i] << ";";
+        std::cout << "---------- Nombre de simulations : " << nbSimulations << " ----------" << std::endl << std::endl;
+        VarianceSwapsHestonMonteCarloPricer mcPricer(broadieKayaSchemeQE,nbSimulations);
+        MonteCarloEstimate mcEstimate = mcPricer.estimate(varianceSwap);
+        std::cout << "MC : " << mcEstimate.price << " +- " << mcEstimate.standardError << std::endl;
+
+        VarianceSwapsHestonMonteCarloPricer qmcPricer(broadieKayaSchemeQE,nbSimulations,1,256,
+                                                      SamplingMethod::QuasiRandom,16);
+        MonteCarloEstimate qmcEstimate = qmcPricer.estimate(varianceSwap);
+        std::cout << "QMC : " << qmcEstimate.price << " +- " << qmcEstimate.standardError << std::endl << std::endl;
+
+        file << nbSimulations << ";";
         file << analyticalPrice << ";";
-        std::vector<double> timePoints, temp;
-        for(std::size_t j = 0; j < dates.size()-1; j++)
-        {
-            temp = MathFunctions::buildLinearSpace(dates[j],dates[j+1],nbTimePoints[i]);
-            timePoints.insert(timePoints.end(), temp.begin(), temp.end()-1);
-            if(j == dates.size()-2)
-                timePoints.push_back(temp.back());
-        }
-        std::cout << "---------- Nombre de points : " << nbTimePoints[i] << " ----------" << std::endl << std::endl;
-        std::cout << "Computation of the price using TG + BroadieKaya" << std::endl;
-        TruncatedGaussianScheme truncatedGaussianScheme(timePoints,hestonModel);
-        BroadieKayaScheme broadieKayaSchemeTG(truncatedGaussianScheme);
-        VarianceSwapsHestonMonteCarloPricer mcPricerBKTG(broadieKayaSchemeTG,nbSimulations);
-        double BKTGprice = mcPricerBKTG.price(varianceSwap);
-        std::cout << BKTGprice << std::endl << std::endl;
-        file << BKTGprice << ";";
+        file << mcEstimate.price << ";";
+        file << mcEstimate.standardError << ";";
+        file << qmcEstimate.price << ";";
+        file << qmcEstimate.standardError << "\n";
+    }
+    file.close();
+}
+
+void testControlVariate()
+{
+    //Heston model parameters
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+    VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+
+    double maturity = 1.0;
+    size_t nbSimulations = 16384;
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,maturity,201);
+
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_control_variate.csv");
+    file << "Nombre d'observations;Prix Analytique;Prix MC;Erreur MC;Prix MC avec variable de controle;Erreur MC avec variable de controle \n";
+
+    //The numbers of observations are chosen so that the observation dates are on the time grid
+    for(size_t nbOfObservations : {3, 5, 11, 26, 51, 101, 201})
+    {
+        VarianceSwap varianceSwap(maturity,nbOfObservations);
+        double analyticalPrice = anPricer.price(varianceSwap);
+        std::cout << "---------- Nombre d'observations : " << nbOfObservations << " ----------" << std::endl;
+        std::cout << "Prix analytique : " << analyticalPrice << std::endl;
+
+        VarianceSwapsHestonMonteCarloPricer mcPricer(broadieKayaSchemeQE,nbSimulations);
+        MonteCarloEstimate mcEstimate = mcPricer.estimate(varianceSwap);
+        std::cout << "MC : " << mcEstimate.price << " +- " << mcEstimate.standardError << std::endl;
+
+        VarianceSwapsHestonMonteCarloPricer cvPricer(broadieKayaSchemeQE,nbSimulations,1,256,
+                                                     SamplingMethod::PseudoRandom,16,true);
+        MonteCarloEstimate cvEstimate = cvPricer.estimate(varianceSwap);
+        std::cout << "MC avec variable de controle : " << cvEstimate.price << " +- "
+                  << cvEstimate.standardError << std::endl << std::endl;
+
+        file << nbOfObservations << ";";
+        file << analyticalPrice << ";";
+        file << mcEstimate.price << ";";
+        file << mcEstimate.standardError << ";";
+        file << cvEstimate.price << ";";
+        file << cvEstimate.standardError << "\n";
+    }
+    file.close();
+}
+
+void testAntitheticVariates()
+{
+    //Heston model parameters of the case I, the correlation varying
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, V0 = 0.04, X0 = 100;
+    std::vector<double> rhos = {-0.9, -0.5, 0., 0.5};
+
+    //Variance swap parameters
+    double maturity = 10.0;
+    size_t nbOfObservations = 2*maturity+1;
+    VarianceSwap varianceSwap(maturity,nbOfObservations);
+
+    size_t nbSimulations = 20000;
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,maturity,1001);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_antithetic_variates.csv");
+    file << "Correlation;Prix Analytique;Prix MC;Erreur MC;Temps MC (s);Prix antithetique;Erreur antithetique;Temps antithetique (s) \n";
+
+    for(size_t i = 0; i < rhos.size(); i++)
+    {
+        HestonModel hestonModel(r,drift,kappa,theta,eps,rhos[i],V0,X0);
+        VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+        double analyticalPrice = anPricer.price(varianceSwap);
+        std::cout << "---------- Correlation : " << rhos[i] << " ----------" << std::endl;
+        std::cout << "Prix analytique : " << analyticalPrice << std::endl;
 
-        std::cout << "Computation of the price using QE + BroadieKaya" << std::endl;
         QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
         BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
-        VarianceSwapsHestonMonteCarloPricer mcPricerBKQE(broadieKayaSchemeQE,nbSimulations);
-        double BKQEprice = mcPricerBKQE.price(varianceSwap);
-        std::cout << BKQEprice << std::endl << std::endl << std::endl;
-        file << BKQEprice << "\n";
+
+        auto start = std::chrono::steady_clock::now();
+        VarianceSwapsHestonMonteCarloPricer mcPricer(broadieKayaSchemeQE,nbSimulations);
+        MonteCarloEstimate mcEstimate = mcPricer.estimate(varianceSwap);
+        double mcTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        std::cout << "MC : " << mcEstimate.price << " +- " << mcEstimate.standardError
+                  << " (" << mcTime << " s)" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        VarianceSwapsHestonMonteCarloPricer avPricer(broadieKayaSchemeQE,nbSimulations,1,256,
+                                                     SamplingMethod::Antithetic);
+        MonteCarloEstimate avEstimate = avPricer.estimate(varianceSwap);
+        double avTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        std::cout << "Antithetique : " << avEstimate.price << " +- " << avEstimate.standardError
+                  << " (" << avTime << " s)" << std::endl << std::endl;
+
+        file << rhos[i] << ";";
+        file << analyticalPrice << ";";
+        file << mcEstimate.price << ";";
+        file << mcEstimate.standardError << ";";
+        file << mcTime << ";";
+        file << avEstimate.price << ";";
+        file << avEstimate.standardError << ";";
+        file << avTime << "\n";
+    }
+    file.close();
+}
+
+void testStoppingRules()
+{
+    //Heston model parameters
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //Variance swap parameters
+    double maturity = 1.0;
+    size_t nbOfObservations = 3;
+    VarianceSwap varianceSwap(maturity,nbOfObservations);
+
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,maturity,201);
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
+
+    //The number of simulations is only an upper bound for the stopping rules
+    size_t maxNbSimulations = 10000000;
+    VarianceSwapsHestonMonteCarloPricer mcPricer(broadieKayaSchemeQE,maxNbSimulations);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_stopping_rules.csv");
+    file << "Regle d'arret;Parametre;Prix MC;Erreur MC;Borne inferieure;Borne superieure;Nombre de simulations;Temps (s) \n";
+
+    auto writeEstimate = [&file](const std::string& rule, double parameter, const MonteCarloEstimate& estimate)
+    {
+        std::cout << rule << " " << parameter << " : " << estimate.price << " +- " << estimate.standardError
+                  << " [" << estimate.lowerBound << ", " << estimate.upperBound << "] with "
+                  << estimate.nbSimulations << " simulations in " << estimate.computationTime << " s" << std::endl;
+        file << rule << ";" << parameter << ";";
+        file << estimate.price << ";";
+        file << estimate.standardError << ";";
+        file << estimate.lowerBound << ";";
+        file << estimate.upperBound << ";";
+        file << estimate.nbSimulations << ";";
+        file << estimate.computationTime << "\n";
+    };
+
+    for(double targetRelativeError : {0.05, 0.02, 0.01, 0.005})
+        writeEstimate("Erreur relative", targetRelativeError,
+                      mcPricer.estimateToRelativeError(varianceSwap, targetRelativeError));
+    for(double timeBudget : {0.1, 0.5, 1., 5.})
+        writeEstimate("Temps", timeBudget, mcPricer.estimateWithinTimeBudget(varianceSwap, timeBudget));
+    file.close();
+}
+
+void testBatchAnalyticalPricing()
+{
+    //Random Heston models, the parameters being drawn uniformly in realistic ranges
+    size_t nbModels = 100000;
+    RandomStream stream(MathFunctions::seed);
+    std::vector<HestonModel> hestonModels;
+    for(size_t i = 0; i < nbModels; i++)
+    {
+        double kappa = 0.2 + 2.8*stream.nextUniform(), theta = 0.01 + 0.09*stream.nextUniform(),
+               eps = 0.1 + 1.1*stream.nextUniform(), rho = -0.95 + 1.45*stream.nextUniform(),
+               V0 = 0.01 + 0.09*stream.nextUniform();
+        hestonModels.push_back(HestonModel(0,0,kappa,theta,eps,rho,V0,100));
+    }
+    HestonModelBatch hestonModelBatch(hestonModels);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_batch_analytical_pricing.csv");
+    file << "Nombre d'observations;Modeles par seconde (un pricer par modele);Modeles par seconde (batch);Ecart relatif maximal \n";
+
+    double maturity = 5.0;
+    for(size_t nbOfObservations : {2, 11, 61, 1261})
+    {
+        VarianceSwap varianceSwap(maturity,nbOfObservations);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> prices;
+        for(size_t i = 0; i < nbModels; i++)
+        {
+            VarianceSwapsHestonAnalyticalPricer anPricer(hestonModels[i]);
+            prices.push_back(anPricer.price(varianceSwap));
+        }
+        double scalarTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+        start = std::chrono::steady_clock::now();
+        VarianceSwapsHestonBatchAnalyticalPricer batchPricer(hestonModelBatch);
+        std::vector<double> batchPrices = batchPricer.prices(varianceSwap);
+        double batchTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+        double maxRelativeDifference = 0.;
+        for(size_t i = 0; i < nbModels; i++)
+            maxRelativeDifference = std::max(maxRelativeDifference,
+                                             std::abs(batchPrices[i]-prices[i])/std::abs(prices[i]));
+
+        std::cout << "---------- Nombre d'observations : " << nbOfObservations << " ----------" << std::endl;
+        std::cout << "Un pricer par modele : " << nbModels/scalarTime << " modeles par seconde" << std::endl;
+        std::cout << "Batch : " << nbModels/batchTime << " modeles par seconde" << std::endl;
+        std::cout << "Ecart relatif maximal : " << maxRelativeDifference << std::endl << std::endl;
+
+        file << nbOfObservations << ";";
+        file << nbModels/scalarTime << ";";
+        file << nbModels/batchTime << ";";
+        file << maxRelativeDifference << "\n";
+    }
+    file.close();
+}
+
+void testSensitivities()
+{
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, X0 = 100;
+    std::vector<double> parameters = {0.5, 0.04, 1, -0.9, 0.04}; //kappa, theta, eps, rho, V0
+    std::vector<std::string> names = {"kappa", "theta", "eps", "rho", "V0"};
+    auto buildModel = [&](const std::vector<double>& p)
+    {
+        return HestonModel(r,drift,p[0],p[1],p[2],p[3],p[4],X0);
+    };
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_sensitivities.csv");
+    file << "Nombre d'observations;Parametre;Sensibilite AD;Sensibilite par differences finies;Temps AD (ms);Temps differences finies (ms) \n";
+
+    double maturity = 10.0;
+    for(size_t nbOfObservations : {21, 121, 2521})
+    {
+        VarianceSwap varianceSwap(maturity,nbOfObservations);
+
+        auto start = std::chrono::steady_clock::now();
+        VarianceSwapsHestonAnalyticalPricer anPricer(buildModel(parameters));
+        VarianceSwapSensitivities sensitivities = anPricer.sensitivities(varianceSwap);
+        double adTime = 1000*std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        std::vector<double> adSensitivities = {sensitivities.meanReversionSpeed, sensitivities.meanReversionLevel,
+                                               sensitivities.volOfVol, sensitivities.correlation,
+                                               sensitivities.initialVolatility};
+
+        //Central bump and reprice of each parameter
+        start = std::chrono::steady_clock::now();
+        std::vector<double> bumpSensitivities;
+        for(size_t i = 0; i < parameters.size(); i++)
+        {
+            double bump = 1e-5*std::max(std::abs(parameters[i]), 1e-2);
+            std::vector<double> up = parameters, down = parameters;
+            up[i] += bump;
+            down[i] -= bump;
+            VarianceSwapsHestonAnalyticalPricer upPricer(buildModel(up)), downPricer(buildModel(down));
+            bumpSensitivities.push_back((upPricer.price(varianceSwap)-downPricer.price(varianceSwap))/(2*bump));
+        }
+        double bumpTime = 1000*std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+        std::cout << "---------- Nombre d'observations : " << nbOfObservations << " ----------" << std::endl;
+        std::cout << "Prix : " << sensitivities.price << std::endl;
+        for(size_t i = 0; i < parameters.size(); i++)
+        {
+            std::cout << names[i] << " : " << adSensitivities[i] << " (AD), " << bumpSensitivities[i]
+                      << " (differences finies)" << std::endl;
+            file << nbOfObservations << ";" << names[i] << ";";
+            file << adSensitivities[i] << ";";
+            file << bumpSensitivities[i] << ";";
+            file << adTime << ";";
+            file << bumpTime << "\n";
+        }
+        std::cout << "Temps : " << adTime << " ms (AD), " << bumpTime << " ms (differences finies)"
+                  << std::endl << std::endl;
     }
+    file.close();
+}
 
+void testMonteCarloSensitivities()
+{
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, X0 = 100;
+    std::vector<double> parameters = {0.5, 0.04, 1, -0.9, 0.04}; //kappa, theta, eps, rho, V0
+    std::vector<std::string> names = {"kappa", "theta", "eps", "rho", "V0"};
+    auto buildModel = [&](const std::vector<double>& p)
+    {
+        return HestonModel(r,drift,p[0],p[1],p[2],p[3],p[4],X0);
+    };
+    HestonModel hestonModel = buildModel(parameters);
+
+    //Variance swap parameters
+    double maturity = 1.0;
+    size_t nbOfObservations = 13;
+    VarianceSwap varianceSwap(maturity,nbOfObservations);
+
+    VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+    VarianceSwapSensitivities anSensitivities = anPricer.sensitivities(varianceSwap);
+    std::vector<double> adSensitivities = {anSensitivities.meanReversionSpeed, anSensitivities.meanReversionLevel,
+                                           anSensitivities.volOfVol, anSensitivities.correlation,
+                                           anSensitivities.initialVolatility};
+
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,maturity,97);
+    TruncatedGaussianScheme truncatedGaussianScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeTG(truncatedGaussianScheme);
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    BroadieKayaScheme broadieKayaSchemeQE(quadraticExponentialScheme);
+    size_t nbSimulations = 50000;
+    double relativeBump = 1e-2;
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_mc_sensitivities.csv");
+    file << "Schema;Parametre;Sensibilite analytique;Sensibilite MC;Erreur MC;Erreur MC avec tirages independants \n";
+
+    std::vector<std::string> schemeNames = {"TG", "QE"};
+    std::vector<const HestonLogSpotPathSimulator*> schemes = {&broadieKayaSchemeTG, &broadieKayaSchemeQE};
+    for(size_t schemeIdx = 0; schemeIdx < schemes.size(); schemeIdx++)
+    {
+        VarianceSwapsHestonMonteCarloPricer mcPricer(*schemes[schemeIdx],nbSimulations);
+        MonteCarloSensitivities sensitivities = mcPricer.sensitivities(varianceSwap, relativeBump);
+        std::vector<MonteCarloEstimate> mcSensitivities = {sensitivities.meanReversionSpeed,
+                                                           sensitivities.meanReversionLevel,
+                                                           sensitivities.volOfVol, sensitivities.correlation,
+                                                           sensitivities.initialVolatility};
+        std::cout << "---------- Schema " << schemeNames[schemeIdx] << " ----------" << std::endl;
+        std::cout << "Prix : " << sensitivities.price.price << " +- " << sensitivities.price.standardError
+                  << " (analytique : " << anSensitivities.price << ") en "
+                  << sensitivities.price.computationTime << " s" << std::endl;
+
+        for(size_t i = 0; i < parameters.size(); i++)
+        {
+            /*Same bumps repriced with independent random variables : the standard error of the
+            difference is that of the two prices */
+            double bump = i == 3 ? relativeBump : relativeBump*std::abs(parameters[i]);
+            std::vector<double> up = parameters, down = parameters;
+            up[i] += bump;
+            down[i] -= bump;
+            HestonLogSpotPathSimulator* upScheme = schemes[schemeIdx]->cloneWithModel(buildModel(up));
+            HestonLogSpotPathSimulator* downScheme = schemes[schemeIdx]->cloneWithModel(buildModel(down));
+            VarianceSwapsHestonMonteCarloPricer upPricer(*upScheme,nbSimulations);
+            VarianceSwapsHestonMonteCarloPricer downPricer(*downScheme,nbSimulations);
+            double upError = upPricer.estimate(varianceSwap).standardError;
+            unsigned seed = MathFunctions::seed;
+            MathFunctions::seed = seed+1;
+            double downError = downPricer.estimate(varianceSwap).standardError;
+            MathFunctions::seed = seed;
+            double independentError = std::sqrt(upError*upError+downError*downError)/(2*bump);
+            delete upScheme;
+            delete downScheme;
+
+            std::cout << names[i] << " : " << mcSensitivities[i].price << " +- " << mcSensitivities[i].standardError
+                      << " (analytique : " << adSensitivities[i] << ", erreur avec tirages independants : "
+                      << independentError << ")" << std::endl;
+            file << schemeNames[schemeIdx] << ";" << names[i] << ";";
+            file << adSensitivities[i] << ";";
+            file << mcSensitivities[i].price << ";";
+            file << mcSensitivities[i].standardError << ";";
+            file << independentError << "\n";
+        }
+        std::cout << std::endl;
+    }
     file.close();
 }
 
+void testCalibration()
+{
+    //Heston model parameters of the market, eps and rho being known from the vanilla options
+    double r = 0, drift = 0, eps = 0.6, rho = -0.7, X0 = 100;
+    HestonModel marketModel(r,drift,1.5,0.05,eps,rho,0.03,X0);
+    //Market of the next day, to which the calibration is warm started from the model of the first day
+    HestonModel nextDayMarketModel(r,drift,1.45,0.052,eps,rho,0.032,X0);
+    HestonModel coldStartModel(r,drift,0.5,0.04,eps,rho,0.04,X0);
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_calibration.csv");
+    file << "Nombre de cotations;Demarrage;Iterations;Erreur RMS;Temps (ms);kappa;theta;V0 \n";
+
+    for(size_t nbQuotes : {2, 4, 8, 16, 32, 64})
+    {
+        //Variance swaps with daily observations and maturities from 1 month to 10 years
+        std::vector<VarianceSwap> varianceSwaps;
+        std::vector<double> maturities = MathFunctions::buildLinearSpace(std::log(1./12.),std::log(10.),nbQuotes);
+        for(size_t i = 0; i < nbQuotes; i++)
+        {
+            double maturity = std::round(252*std::exp(maturities[i]))/252;
+            varianceSwaps.push_back(VarianceSwap(maturity,size_t(252*maturity+0.5)+1));
+        }
+        auto fairStrikes = [&varianceSwaps](const HestonModel& hestonModel)
+        {
+            VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+            std::vector<double> strikes;
+            for(size_t i = 0; i < varianceSwaps.size(); i++)
+                strikes.push_back(anPricer.price(varianceSwaps[i]));
+            return strikes;
+        };
+
+        VarianceSwapsHestonCalibrator calibrator(varianceSwaps,fairStrikes(marketModel));
+        CalibrationResult coldStart = calibrator.calibrate(coldStartModel);
+        VarianceSwapsHestonCalibrator nextDayCalibrator(varianceSwaps,fairStrikes(nextDayMarketModel));
+        CalibrationResult warmStart = nextDayCalibrator.calibrate(coldStart.model);
+
+        std::vector<std::string> startNames = {"Froid", "Chaud"};
+        std::vector<CalibrationResult> results = {coldStart, warmStart};
+        for(size_t i = 0; i < results.size(); i++)
+        {
+            const CalibrationResult& result = results[i];
+            std::cout << nbQuotes << " cotations, demarrage " << startNames[i] << " : " << result.nbIterations
+                      << " iterations, erreur RMS " << result.rootMeanSquaredError << ", "
+                      << 1000*result.computationTime << " ms (kappa = " << result.model.getMeanReversionSpeed()
+                      << ", theta = " << result.model.getMeanReversionLevel()
+                      << ", V0 = " << result.model.getInitialVolatility() << ")" << std::endl;
+            file << nbQuotes << ";" << startNames[i] << ";";
+            file << result.nbIterations << ";";
+            file << result.rootMeanSquaredError << ";";
+            file << 1000*result.computationTime << ";";
+            file << result.model.getMeanReversionSpeed() << ";";
+            file << result.model.getMeanReversionLevel() << ";";
+            file << result.model.getInitialVolatility() << "\n";
+        }
+    }
+    file.close();
+}
+
+void testInstrumentation()
+{
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //Variance swap with monthly observations
+    double maturity = 1.0;
+    VarianceSwap varianceSwap(maturity,13);
+
+    size_t nbSimulations = 100000;
+    size_t nbTimePoints = 21;
+    std::vector<double> dates = varianceSwap.getDates();
+    std::vector<double> timePoints = TimeGrid(dates,nbTimePoints).getTimePoints();
+
+    TruncatedGaussianScheme truncatedGaussianScheme(timePoints,hestonModel);
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    std::vector<std::string> schemeNames = {"BKTG", "BKQE"};
+    std::vector<BroadieKayaScheme> schemes = {BroadieKayaScheme(truncatedGaussianScheme),
+                                              BroadieKayaScheme(quadraticExponentialScheme)};
+
+    //The counters and timers are only filled when compiled with -DENABLE_INSTRUMENTATION=ON
+    for(size_t i = 0; i < schemes.size(); i++)
+    {
+        VarianceSwapsHestonMonteCarloPricer mcPricer(schemes[i],nbSimulations);
+        std::cout << "---------- " << schemeNames[i] << " : " << mcPricer.price(varianceSwap)
+                  << " ----------" << std::endl;
+        Instrumentation::Report report = Instrumentation::lastRunReport();
+        report.print();
+        report.writeJson(rootPath+"test_instrumentation_"+schemeNames[i]+".json");
+        std::cout << std::endl;
+    }
+}
+
+void testVarianceKernels()
+{
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //The paths are advanced on a grid of 240 steps, with new random variables at each step
+    size_t nbPaths = 100000;
+    size_t blockSize = 256;
+    size_t nbTimePoints = 241;
+    std::vector<double> timePoints = MathFunctions::buildLinearSpace(0,1.0,nbTimePoints);
+    TruncatedGaussianScheme truncatedGaussianScheme(timePoints,hestonModel);
+    QuadraticExponentialScheme quadraticExponentialScheme(timePoints,hestonModel);
+    std::vector<std::string> schemeNames = {"TG", "QE"};
+    std::vector<const HestonVariancePathSimulator*> schemes = {&truncatedGaussianScheme, &quadraticExponentialScheme};
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_variance_kernels.csv");
+    file << "Schema;Pas scalaires par seconde;Pas batch par seconde;Acceleration;Ecart maximal \n";
+
+    for(size_t i = 0; i < schemes.size(); i++)
+    {
+        RandomStream stream(MathFunctions::seed);
+        std::vector<double> randomVariables(nbPaths), currentValues(nbPaths, V0),
+                            scalarValues(nbPaths), batchValues(nbPaths);
+        std::chrono::duration<double> scalarTime(0.), batchTime(0.);
+        double maxError = 0.;
+        for(size_t index = 0; index < nbTimePoints-1; index++)
+        {
+            if(schemes[i]->getRandomVariableType() == RandomVariableType::Uniform)
+                MathFunctions::simulateUniformRandomVariables(randomVariables.data(), nbPaths, stream);
+            else
+                MathFunctions::simulateGaussianRandomVariables(randomVariables.data(), nbPaths, stream);
+
+            auto start = std::chrono::steady_clock::now();
+            for(size_t p = 0; p < nbPaths; p++)
+                scalarValues[p] = schemes[i]->nextStep(index, currentValues[p], randomVariables[p]);
+            scalarTime += std::chrono::steady_clock::now() - start;
+
+            //The paths are advanced by blocks of the default size of the Monte Carlo pricer
+            start = std::chrono::steady_clock::now();
+            for(size_t p = 0; p < nbPaths; p += blockSize)
+                schemes[i]->nextStepBlock(index, &currentValues[p], &randomVariables[p], &batchValues[p],
+                                          std::min(blockSize, nbPaths-p));
+            batchTime += std::chrono::steady_clock::now() - start;
+
+            //The block version must give the same values as the scalar one, up to rounding errors
+            for(size_t p = 0; p < nbPaths; p++)
+                maxError = std::max(maxError, std::abs(batchValues[p]-scalarValues[p]));
+            currentValues.swap(scalarValues);
+        }
+
+        double nbSteps = double(nbPaths*(nbTimePoints-1));
+        std::cout << schemeNames[i] << " scalar step : " << nbSteps/scalarTime.count() << " steps per second" << std::endl;
+        std::cout << schemeNames[i] << " block step : " << nbSteps/batchTime.count() << " steps per second" << std::endl;
+        std::cout << "Maximum difference : " << maxError << std::endl << std::endl;
+
+        file << schemeNames[i] << ";";
+        file << nbSteps/scalarTime.count() << ";";
+        file << nbSteps/batchTime.count() << ";";
+        file << scalarTime.count()/batchTime.count() << ";";
+        file << maxError << "\n";
+    }
+    file.close();
+}
+
+void testLargeStepSimulation()
+{
+    //Heston model parameters of the case I
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+    double analyticalPrice;
+
+    size_t nbSimulations = 100000;
+    std::vector<size_t> nbOfObservations = {3, 13};
+    std::vector<size_t> nbTimePoints = {11, 51, 201};
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_large_step.csv");
+    file << "Nombre de dates;Schema;Points par periode;Prix analytique;Prix MC;Erreur standard;Temps de calcul \n";
+
+    for(size_t i = 0; i < nbOfObservations.size(); i++)
+    {
+        VarianceSwap varianceSwap(1.0,nbOfObservations[i]);
+        std::vector<double> dates = varianceSwap.getDates();
+        VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+        analyticalPrice = anPricer.price(varianceSwap);
+        std::cout << "---------- " << nbOfObservations[i] << " dates : " << analyticalPrice
+                  << " (analytical) ----------" << std::endl;
+
+        //The exact scheme only simulates the observation dates
+        auto start = std::chrono::steady_clock::now();
+        GammaExpansionScheme gammaExpansionScheme(NoncentralChiSquareScheme(dates,hestonModel));
+        VarianceSwapsHestonMonteCarloPricer mcPricerExact(gammaExpansionScheme,nbSimulations);
+        MonteCarloEstimate estimate = mcPricerExact.estimate(varianceSwap);
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << "NCX2GE : " << estimate.price << " +- " << estimate.standardError << " (" << time.count()
+                  << " s)" << std::endl;
+        file << nbOfObservations[i] << ";NCX2GE;2;" << analyticalPrice << ";" << estimate.price << ";"
+             << estimate.standardError << ";" << time.count() << "\n";
+
+        //The discretized schemes, with more and more points between two dates
+        for(size_t j = 0; j < nbTimePoints.size(); j++)
+        {
+            std::vector<double> timePoints = TimeGrid(dates,nbTimePoints[j]).getTimePoints();
+
+            std::vector<std::string> schemeNames = {"BKTG", "BKQE"};
+            std::vector<BroadieKayaScheme> schemes = {
+                BroadieKayaScheme(TruncatedGaussianScheme(timePoints,hestonModel)),
+                BroadieKayaScheme(QuadraticExponentialScheme(timePoints,hestonModel))};
+            for(size_t l = 0; l < schemes.size(); l++)
+            {
+                start = std::chrono::steady_clock::now();
+                VarianceSwapsHestonMonteCarloPricer mcPricer(schemes[l],nbSimulations);
+                estimate = mcPricer.estimate(varianceSwap);
+                time = std::chrono::steady_clock::now() - start;
+                std::cout << schemeNames[l] << " " << nbTimePoints[j] << " points : " << estimate.price << " +- "
+                          << estimate.standardError << " (" << time.count() << " s)" << std::endl;
+                file << nbOfObservations[i] << ";" << schemeNames[l] << ";" << nbTimePoints[j] << ";"
+                     << analyticalPrice << ";" << estimate.price << ";" << estimate.standardError << ";"
+                     << time.count() << "\n";
+            }
+        }
+        std::cout << std::endl;
+    }
+    file.close();
+}
+
+void testNoncentralChiSquareScheme()
+{
+    //Heston model parameters of the case I, for which the Feller condition is badly violated
+    double r = 0, drift = 0, kappa = 0.5, theta = 0.04, eps = 1, rho = -0.9,
+            V0 = 0.04, X0 = 100;
+    HestonModel hestonModel(r,drift,kappa,theta,eps,rho,V0,X0);
+
+    //Variance swap with semiannual observations
+    VarianceSwap varianceSwap(1.0,3);
+    std::vector<double> dates = varianceSwap.getDates();
+    VarianceSwapsHestonAnalyticalPricer anPricer(hestonModel);
+    double analyticalPrice = anPricer.price(varianceSwap);
+    std::cout << "Analytical price : " << analyticalPrice << std::endl;
+
+    size_t nbSimulations = 100000;
+    std::vector<size_t> nbTimePoints = {6, 11, 21, 51, 201, 1001};
+    std::vector<std::string> schemeNames = {"BKTG", "BKQE", "BKNCX2"};
+
+    //We write our results in a csv file.
+    std::ofstream file;
+    file.open (rootPath+"test_noncentral_chi_square.csv");
+    file << "Schema;Points par periode;Prix analytique;Prix MC;Erreur standard;Temps de calcul \n";
+
+    for(size_t j = 0; j < nbTimePoints.size(); j++)
+    {
+        std::vector<double> timePoints = TimeGrid(dates,nbTimePoints[j]).getTimePoints();
+
+        std::vector<BroadieKayaScheme> schemes = {
+            BroadieKayaScheme(TruncatedGaussianScheme(timePoints,hestonModel)),
+            BroadieKayaScheme(QuadraticExponentialScheme(timePoints,hestonModel)),
+            BroadieKayaScheme(NoncentralChiSquareScheme(timePoints,hestonModel))};
+        for(size_t l = 0; l < schemes.size(); l++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            VarianceSwapsHestonMonteCarloPricer mcPricer(schemes[l],nbSimulations);
+            MonteCarloEstimate estimate = mcPricer.estimate(varianceSwap);
+            std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+            std::cout << schemeNames[l] << " " << nbTimePoints[j] << " points : " << estimate.price << " +- "
+                      << estimate.standardError << " (" << time.count() << " s)" << std::endl;
+            file << schemeNames[l] << ";" << nbTimePoints[j] << ";" << analyticalPrice << ";" << estimate.price
+                 << ";" << estimate.standardError << ";" << time.count() << "\n";
+        }
+    }
+    file.close();
+
+    /*Comparison of BKNCX2 on the observation dates only with BKQE with 10 and 20 steps per period.
+    At equal cost, BKNCX2 simulates as many paths as it can in the time taken by BKQE, and the root mean square
+    errors are compared, BKNCX2 having no bias. At equal bias, BKNCX2 simulates enough paths for its standard error
+    to equal the bias of BKQE, the error below which BKQE can't go whatever its number of paths. When the bias isn't
+    resolved, it is replaced by twice its standard error, so that the number of paths is then a lower bound.
+    More paths are simulated than above, with the integrated variance as control variate (its expectation is exact
+    for both schemes), to resolve as much of the bias as possible */
+    size_t nbComparisonSimulations = 1000000;
+    BroadieKayaScheme exactScheme(NoncentralChiSquareScheme(TimeGrid(dates,2).getTimePoints(),hestonModel));
+    MonteCarloEstimate exactEstimate =
+            VarianceSwapsHestonMonteCarloPricer(exactScheme,nbComparisonSimulations,1,256,SamplingMethod::PseudoRandom,
+                                                16,true).estimate(varianceSwap);
+    double exactTimePerPath = exactEstimate.computationTime/double(exactEstimate.nbSimulations);
+    double exactStandardDeviation = exactEstimate.standardError*std::sqrt(double(exactEstimate.nbSimulations));
+    std::cout << "BKNCX2 on the observation dates : " << exactEstimate.price << " +- " << exactEstimate.standardError
+              << " (" << exactEstimate.computationTime << " s)" << std::endl;
+
+    file.open (rootPath+"test_noncentral_chi_square_equal_cost.csv");
+    file << "Points par periode BKQE;Biais BKQE;Erreur standard BKQE;Borne du biais BKQE;REQM BKQE;Temps BKQE;"
+         << "Simulations BKNCX2 a cout egal;REQM BKNCX2 a cout egal;"
+         << "Simulations BKNCX2 a biais egal;Temps BKNCX2 a biais egal \n";
+    for(size_t nbPoints : {11, 21})
+    {
+        BroadieKayaScheme qeScheme(QuadraticExponentialScheme(TimeGrid(dates,nbPoints).getTimePoints(),hestonModel));
+        MonteCarloEstimate qeEstimate =
+                VarianceSwapsHestonMonteCarloPricer(qeScheme,nbComparisonSimulations,1,256,SamplingMethod::PseudoRandom,
+                                                    16,true).estimate(varianceSwap);
+        double bias = qeEstimate.price - analyticalPrice;
+        double qeError = std::sqrt(bias*bias + qeEstimate.standardError*qeEstimate.standardError);
+        double biasBound = std::max(std::abs(bias), 2.*qeEstimate.standardError);
+
+        size_t equalCostSimulations = size_t(qeEstimate.computationTime/exactTimePerPath);
+        double equalCostError = exactStandardDeviation/std::sqrt(double(equalCostSimulations));
+        size_t equalBiasSimulations = size_t(std::ceil(exactStandardDeviation*exactStandardDeviation
+                                                       /(biasBound*biasBound)));
+        double equalBiasTime = double(equalBiasSimulations)*exactTimePerPath;
+
+        std::cout << "BKQE " << nbPoints << " points : bias " << bias << " +- " << qeEstimate.standardError
+                  << " (bound " << biasBound << "), RMSE " << qeError << " in " << qeEstimate.computationTime << " s; BKNCX2 at equal cost : "
+                  << equalCostSimulations << " paths, RMSE " << equalCostError << "; BKNCX2 at equal bias : "
+                  << equalBiasSimulations << " paths in " << equalBiasTime << " s" << std::endl;
+        file << nbPoints << ";" << bias << ";" << qeEstimate.standardError << ";" << biasBound << ";" << qeError << ";"
+             << qeEstimate.computationTime << ";" << equalCostSimulations << ";" << equalCostError << ";"
+             << equalBiasSimulations << ";" << equalBiasTime << "\n";
+    }
+    file.close();
+}
+
+void testAdaptiveTimeGrid()
+{
+    /*Heston model and variance swap parameters (the default ones), with a fast mean reversion on the periods
+    and a lower volatility of the variance, so that the bias of the coarse grids stands out of the noise */
+    SweepPoint basePoint;
+    basePoint.meanReversionSpeed = 5.0;
+    basePoint.volOfVol = 0.5;
+    basePoint.maturity = 1.0;
+    basePoint.nbOfObservationsPerYear = 2;
+    basePoint.nbSimulations = 1000000;
+
+    //For the same numbers of steps, the uniform and the adaptive grids
+    ParameterSweep sweep(basePoint, {VarianceScheme::TruncatedGaussian, VarianceScheme::QuadraticExponential});
+    sweep.addAxis(SweepParameter::NbTimePointsPerPeriod, {3,5,11,21,51,201});
+    sweep.addAxis(SweepParameter::AdaptiveTimeGrid, {0,1});
+
+    std::vector<SweepResult> results = sweep.run();
+    for(size_t i = 0; i < results.size(); i++)
+        std::cout << results[i].point.nbTimePointsPerPeriod << " points"
+                  << (results[i].point.adaptiveTimeGrid ? " (adaptive) : " : " (uniform) : ")
+                  << results[i].analyticalPrice << " (analytical), " << results[i].monteCarloEstimates[0].price
+                  << " (TG + BroadieKaya), " << results[i].monteCarloEstimates[1].price << " (QE + BroadieKaya)"
+                  << std::endl;
+
+    /*We write our results in a csv file*/
+    sweep.writeCsv(rootPath+"test_adaptive_time_grid.csv", results);
+}
 
 int main()
 {   
@@ -357,5 +1160,21 @@ int main()
     //testNbOfSimulations();
     //testKappaParameter();
     // testMaturityParameter();
+    // testMultiThreading();
+    // testGaussianSamplers();
+    // testNormalCDFInverseBatch();
+    // testQuasiMonteCarlo();
+    // testControlVariate();
+    // testAntitheticVariates();
+    // testStoppingRules();
+    // testBatchAnalyticalPricing();
+    // testSensitivities();
+    // testMonteCarloSensitivities();
+    // testCalibration();
+    // testInstrumentation();
+    // testVarianceKernels();
+    // testLargeStepSimulation();
+    // testNoncentralChiSquareScheme();
+    // testAdaptiveTimeGrid();
     return 0;
 }